@@ -0,0 +1,75 @@
+/*
+ * SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "breezeanimationclock.h"
+
+#include <QTest>
+
+#include <memory>
+
+using namespace Breeze;
+
+class AnimationClockTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void finish();
+
+    void deleteFromFinishCallback();
+};
+
+//________________________________________________________________
+void AnimationClockTest::finish()
+{
+    qreal last = 0;
+    ClockedAnimation animation([&last](qreal value) {
+        last = value;
+    });
+    animation.setDuration(50);
+    animation.start();
+
+    QCOMPARE(animation.state(), QAbstractAnimation::Running);
+    QTRY_COMPARE(animation.state(), QAbstractAnimation::Stopped);
+    QCOMPARE(last, 1.0);
+}
+
+//________________________________________________________________
+void AnimationClockTest::deleteFromFinishCallback()
+{
+    // both animations finish in the same tick, the first one listed is deleted by the other one's callback
+    std::unique_ptr<ClockedAnimation> deleted;
+    bool finished = false;
+
+    deleted = std::make_unique<ClockedAnimation>([](qreal) {});
+    ClockedAnimation deleting([&deleted, &finished](qreal value) {
+        if (value == 1.0) {
+            deleted.reset();
+            finished = true;
+        }
+    });
+
+    deleted->setDuration(0);
+    deleting.setDuration(0);
+    deleted->start();
+    deleting.start();
+
+    QTRY_VERIFY(finished);
+    QVERIFY(!deleted);
+
+    // the clock must still be able to run animations afterwards
+    bool restarted = false;
+    deleted = std::make_unique<ClockedAnimation>([&restarted](qreal value) {
+        restarted = (value == 1.0);
+    });
+    deleted->setDuration(0);
+    deleted->start();
+    QTRY_VERIFY(restarted);
+}
+
+QTEST_GUILESS_MAIN(AnimationClockTest)
+
+#include "animationclocktest.moc"
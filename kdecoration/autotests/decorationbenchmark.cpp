@@ -0,0 +1,612 @@
+/*
+ * SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "breezedecoration.h"
+#include "breezesettingsprovider.h"
+
+#include <KDecoration3/Private/DecoratedWindowPrivate>
+#include <KDecoration3/Private/DecorationBridge>
+#include <KDecoration3/Private/DecorationSettingsPrivate>
+
+#include <QPainter>
+#include <QStandardPaths>
+#include <QTest>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#if defined(__GLIBC__)
+/**
+ * Count allocations where they all end up.
+ *
+ * Qt's containers, QImage buffers and operator new all allocate through malloc,
+ * calloc or realloc. The definitions in the executable take precedence over the
+ * ones of the C library for every shared library, and forward to glibc's own.
+ **/
+#define BREEZE_COUNT_ALLOCATIONS 1
+
+//* heap allocations made by any code in the process
+static std::atomic<quint64> s_allocations{0};
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+void __libc_free(void *pointer);
+
+void *malloc(size_t size)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+
+void free(void *pointer)
+{
+    __libc_free(pointer);
+}
+}
+#endif
+
+namespace
+{
+//* window the decoration is attached to, as the compositor would provide it
+class StandInWindow : public KDecoration3::DecoratedWindowPrivate
+{
+public:
+    StandInWindow(KDecoration3::DecoratedWindow *window, KDecoration3::Decoration *decoration)
+        : KDecoration3::DecoratedWindowPrivate(window, decoration)
+    {
+    }
+
+    //*@name changes, notified the way the compositor does
+    //@{
+    void setActive(bool active)
+    {
+        m_active = active;
+        Q_EMIT window()->activeChanged(active);
+    }
+
+    void setCaption(const QString &caption)
+    {
+        m_caption = caption;
+        Q_EMIT window()->captionChanged(caption);
+    }
+
+    void setScale(qreal scale)
+    {
+        m_scale = scale;
+        Q_EMIT window()->nextScaleChanged();
+        Q_EMIT window()->scaleChanged();
+    }
+    //@}
+
+    bool isActive() const override
+    {
+        return m_active;
+    }
+
+    QString caption() const override
+    {
+        return m_caption;
+    }
+
+    bool isOnAllDesktops() const override
+    {
+        return false;
+    }
+
+    bool isShaded() const override
+    {
+        return false;
+    }
+
+    QIcon icon() const override
+    {
+        return QIcon();
+    }
+
+    bool isMaximized() const override
+    {
+        return false;
+    }
+
+    bool isMaximizedHorizontally() const override
+    {
+        return false;
+    }
+
+    bool isMaximizedVertically() const override
+    {
+        return false;
+    }
+
+    bool isKeepAbove() const override
+    {
+        return false;
+    }
+
+    bool isKeepBelow() const override
+    {
+        return false;
+    }
+
+    bool isCloseable() const override
+    {
+        return true;
+    }
+
+    bool isMaximizeable() const override
+    {
+        return true;
+    }
+
+    bool isMinimizeable() const override
+    {
+        return true;
+    }
+
+    bool providesContextHelp() const override
+    {
+        return false;
+    }
+
+    bool isModal() const override
+    {
+        return false;
+    }
+
+    bool isShadeable() const override
+    {
+        return true;
+    }
+
+    bool isMoveable() const override
+    {
+        return true;
+    }
+
+    bool isResizeable() const override
+    {
+        return true;
+    }
+
+    qreal width() const override
+    {
+        return m_size.width();
+    }
+
+    qreal height() const override
+    {
+        return m_size.height();
+    }
+
+    QSizeF size() const override
+    {
+        return m_size;
+    }
+
+    QPalette palette() const override
+    {
+        return QPalette();
+    }
+
+    Qt::Edges adjacentScreenEdges() const override
+    {
+        return Qt::Edges();
+    }
+
+    QString windowClass() const override
+    {
+        return QStringLiteral("benchmark benchmark");
+    }
+
+    bool hasApplicationMenu() const override
+    {
+        return false;
+    }
+
+    bool isApplicationMenuActive() const override
+    {
+        return false;
+    }
+
+    qreal scale() const override
+    {
+        return m_scale;
+    }
+
+    qreal nextScale() const override
+    {
+        return m_scale;
+    }
+
+    //*@name requests from the decoration, which the benchmark never makes
+    //@{
+    void requestShowToolTip(const QString &) override
+    {
+    }
+
+    void requestHideToolTip() override
+    {
+    }
+
+    void requestClose() override
+    {
+    }
+
+    void requestToggleMaximization(Qt::MouseButtons) override
+    {
+    }
+
+    void requestMinimize() override
+    {
+    }
+
+    void requestContextHelp() override
+    {
+    }
+
+    void requestToggleOnAllDesktops() override
+    {
+    }
+
+    void requestToggleShade() override
+    {
+    }
+
+    void requestToggleKeepAbove() override
+    {
+    }
+
+    void requestToggleKeepBelow() override
+    {
+    }
+
+    void requestShowWindowMenu(const QRect &) override
+    {
+    }
+
+    void requestShowApplicationMenu(const QRect &, int) override
+    {
+    }
+
+    void showApplicationMenu(int) override
+    {
+    }
+    //@}
+
+private:
+    bool m_active = false;
+    QString m_caption = QStringLiteral("Untitled - Editor");
+    QSizeF m_size = QSizeF(800, 600);
+    qreal m_scale = 1.0;
+};
+
+//* decoration settings, as the compositor would provide them
+class StandInSettings : public KDecoration3::DecorationSettingsPrivate
+{
+public:
+    explicit StandInSettings(KDecoration3::DecorationSettings *parent)
+        : KDecoration3::DecorationSettingsPrivate(parent)
+    {
+    }
+
+    bool isAlphaChannelSupported() const override
+    {
+        return true;
+    }
+
+    bool isOnAllDesktopsAvailable() const override
+    {
+        return true;
+    }
+
+    bool isCloseOnDoubleClickOnMenu() const override
+    {
+        return false;
+    }
+
+    QList<KDecoration3::DecorationButtonType> decorationButtonsLeft() const override
+    {
+        return {KDecoration3::DecorationButtonType::Menu, KDecoration3::DecorationButtonType::OnAllDesktops};
+    }
+
+    QList<KDecoration3::DecorationButtonType> decorationButtonsRight() const override
+    {
+        return {KDecoration3::DecorationButtonType::ContextHelp,
+                KDecoration3::DecorationButtonType::Minimize,
+                KDecoration3::DecorationButtonType::Maximize,
+                KDecoration3::DecorationButtonType::Close};
+    }
+
+    KDecoration3::BorderSize borderSize() const override
+    {
+        return KDecoration3::BorderSize::Normal;
+    }
+};
+
+//* creates the stand-in windows and settings for the decorations
+class StandInBridge : public KDecoration3::DecorationBridge
+{
+public:
+    std::unique_ptr<KDecoration3::DecoratedWindowPrivate> createClient(KDecoration3::DecoratedWindow *window, KDecoration3::Decoration *decoration) override
+    {
+        auto standIn = std::make_unique<StandInWindow>(window, decoration);
+        m_lastWindow = standIn.get();
+        return standIn;
+    }
+
+    std::unique_ptr<KDecoration3::DecorationSettingsPrivate> settings(KDecoration3::DecorationSettings *parent) override
+    {
+        return std::make_unique<StandInSettings>(parent);
+    }
+
+    //* window of the last created decoration
+    StandInWindow *lastWindow() const
+    {
+        return m_lastWindow;
+    }
+
+private:
+    StandInWindow *m_lastWindow = nullptr;
+};
+
+//* a number of decorated windows
+class Windows
+{
+public:
+    explicit Windows(int count)
+        : m_settings(std::make_shared<KDecoration3::DecorationSettings>(&m_bridge))
+    {
+        const QVariantList args{QVariantMap{{QStringLiteral("bridge"), QVariant::fromValue<KDecoration3::DecorationBridge *>(&m_bridge)}}};
+        for (int i = 0; i < count; ++i) {
+            auto decoration = std::make_unique<Breeze::Decoration>(nullptr, args);
+            decoration->setSettings(m_settings);
+            decoration->create();
+            decoration->init();
+
+            m_windows.push_back(m_bridge.lastWindow());
+            m_decorations.push_back(std::move(decoration));
+        }
+
+        // lay everything out once, as the compositor would show the windows first
+        QCoreApplication::processEvents();
+    }
+
+    ~Windows()
+    {
+        // decorations go before their settings and their bridge
+        m_decorations.clear();
+    }
+
+    int count() const
+    {
+        return m_decorations.size();
+    }
+
+    Breeze::Decoration *decoration(int index) const
+    {
+        return m_decorations.at(index).get();
+    }
+
+    StandInWindow *window(int index) const
+    {
+        return m_windows.at(index);
+    }
+
+private:
+    StandInBridge m_bridge;
+    std::shared_ptr<KDecoration3::DecorationSettings> m_settings;
+    std::vector<std::unique_ptr<Breeze::Decoration>> m_decorations;
+    std::vector<StandInWindow *> m_windows;
+};
+
+}
+
+using namespace Breeze;
+
+/**
+ * Measure what decorations cost the compositor.
+ *
+ * Every benchmark applies one operation to all windows, then lets the event
+ * loop run the layouts that the operation scheduled. Next to the time, the
+ * number of heap allocations per window is printed, with glibc only.
+ **/
+class DecorationBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void paint_data();
+    void paint();
+
+    void reconfigure_data();
+    void reconfigure();
+
+    void toggleActive_data();
+    void toggleActive();
+
+    void changeCaption_data();
+    void changeCaption();
+
+    void changeScale_data();
+    void changeScale();
+
+private:
+    static void addRows();
+
+    //* run the operation on all windows, and within QBENCHMARK
+    static void measure(const Windows &windows, const std::function<void()> &operation);
+
+    //* paint one window
+    static void paintWindow(Decoration *decoration, qreal scale);
+};
+
+//________________________________________________________________
+void DecorationBenchmark::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+//________________________________________________________________
+void DecorationBenchmark::addRows()
+{
+    QTest::addColumn<int>("count");
+
+    for (int count : {1, 100, 1000}) {
+        QTest::addRow("%d windows", count) << count;
+    }
+}
+
+//________________________________________________________________
+void DecorationBenchmark::measure(const Windows &windows, const std::function<void()> &operation)
+{
+#ifdef BREEZE_COUNT_ALLOCATIONS
+    const quint64 allocations = s_allocations.load(std::memory_order_relaxed);
+    operation();
+    QCoreApplication::processEvents();
+    qDebug() << qreal(s_allocations.load(std::memory_order_relaxed) - allocations) / windows.count() << "allocations per window";
+#endif
+
+    QBENCHMARK {
+        operation();
+        QCoreApplication::processEvents();
+    }
+}
+
+//________________________________________________________________
+void DecorationBenchmark::paintWindow(Decoration *decoration, qreal scale)
+{
+    const QRectF rect = decoration->rect();
+
+    QImage image((rect.size() * scale).toSize(), QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(scale);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    decoration->paint(&painter, rect);
+}
+
+//________________________________________________________________
+void DecorationBenchmark::paint_data()
+{
+    addRows();
+}
+
+//________________________________________________________________
+void DecorationBenchmark::paint()
+{
+    QFETCH(int, count);
+
+    const Windows windows(count);
+    measure(windows, [&windows]() {
+        for (int i = 0; i < windows.count(); ++i) {
+            paintWindow(windows.decoration(i), windows.window(i)->scale());
+        }
+    });
+}
+
+//________________________________________________________________
+void DecorationBenchmark::reconfigure_data()
+{
+    addRows();
+}
+
+//________________________________________________________________
+void DecorationBenchmark::reconfigure()
+{
+    QFETCH(int, count);
+
+    // the configuration is read once, then every decoration reconfigures
+    const Windows windows(count);
+    measure(windows, []() {
+        SettingsProvider::self()->reconfigure();
+        Q_EMIT SettingsProvider::self()->reconfigured();
+    });
+}
+
+//________________________________________________________________
+void DecorationBenchmark::toggleActive_data()
+{
+    addRows();
+}
+
+//________________________________________________________________
+void DecorationBenchmark::toggleActive()
+{
+    QFETCH(int, count);
+
+    const Windows windows(count);
+    measure(windows, [&windows]() {
+        for (int i = 0; i < windows.count(); ++i) {
+            windows.window(i)->setActive(!windows.window(i)->isActive());
+        }
+    });
+}
+
+//________________________________________________________________
+void DecorationBenchmark::changeCaption_data()
+{
+    addRows();
+}
+
+//________________________________________________________________
+void DecorationBenchmark::changeCaption()
+{
+    QFETCH(int, count);
+
+    // captions change, and get painted again
+    const Windows windows(count);
+    int next = 0;
+    measure(windows, [&windows, &next]() {
+        const QString caption = QStringLiteral("Document %1 - Editor").arg(next++);
+        for (int i = 0; i < windows.count(); ++i) {
+            windows.window(i)->setCaption(caption);
+            paintWindow(windows.decoration(i), windows.window(i)->scale());
+        }
+    });
+}
+
+//________________________________________________________________
+void DecorationBenchmark::changeScale_data()
+{
+    addRows();
+}
+
+//________________________________________________________________
+void DecorationBenchmark::changeScale()
+{
+    QFETCH(int, count);
+
+    // windows move back and forth between two outputs with different scales
+    const Windows windows(count);
+    measure(windows, [&windows]() {
+        for (int i = 0; i < windows.count(); ++i) {
+            StandInWindow *window = windows.window(i);
+            window->setScale(window->scale() == 1.0 ? 1.5 : 1.0);
+        }
+    });
+}
+
+QTEST_MAIN(DecorationBenchmark)
+
+#include "decorationbenchmark.moc"
@@ -0,0 +1,161 @@
+/*
+ * SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "breezeexceptionmatcher.h"
+
+#include <QStandardPaths>
+#include <QTest>
+
+using namespace Breeze;
+
+class ExceptionMatcherBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void compile_data();
+    void compile();
+
+    void matchClass_data();
+    void matchClass();
+
+    void matchTitle_data();
+    void matchTitle();
+
+private:
+    static void addRows();
+
+    //* exceptions mixing every kind of pattern
+    static InternalSettingsList exceptions(int count);
+};
+
+//________________________________________________________________
+InternalSettingsList ExceptionMatcherBenchmark::exceptions(int count)
+{
+    InternalSettingsList list;
+    for (int i = 0; i < count; ++i) {
+        InternalSettingsPtr exception(new InternalSettings());
+        exception->setEnabled(true);
+
+        const QString name = QStringLiteral("application%1").arg(i);
+        switch (i % 4) {
+        case 0:
+            exception->setExceptionType(InternalSettings::ExceptionWindowClassName);
+            exception->setExceptionPattern(QStringLiteral("^%1$").arg(name));
+            break;
+        case 1:
+            exception->setExceptionType(InternalSettings::ExceptionWindowClassName);
+            exception->setExceptionPattern(name);
+            break;
+        case 2:
+            exception->setExceptionType(InternalSettings::ExceptionWindowClassName);
+            exception->setExceptionPattern(QStringLiteral("%1(-[a-z]+)?").arg(name));
+            break;
+        case 3:
+            exception->setExceptionType(InternalSettings::ExceptionWindowTitle);
+            exception->setExceptionPattern(QStringLiteral("%1 - .*").arg(name));
+            break;
+        }
+
+        list.append(exception);
+    }
+
+    return list;
+}
+
+//________________________________________________________________
+void ExceptionMatcherBenchmark::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+//________________________________________________________________
+void ExceptionMatcherBenchmark::addRows()
+{
+    QTest::addColumn<int>("count");
+
+    for (int count : {0, 1, 10, 40, 100, 1000}) {
+        QTest::addRow("%d exceptions", count) << count;
+    }
+}
+
+//________________________________________________________________
+void ExceptionMatcherBenchmark::compile_data()
+{
+    addRows();
+}
+
+//________________________________________________________________
+void ExceptionMatcherBenchmark::compile()
+{
+    QFETCH(int, count);
+
+    // this runs once per reconfigure
+    const InternalSettingsList list = exceptions(count);
+    QBENCHMARK {
+        const ExceptionMatcher matcher(list);
+        Q_UNUSED(matcher)
+    }
+}
+
+//________________________________________________________________
+void ExceptionMatcherBenchmark::matchClass_data()
+{
+    addRows();
+}
+
+//________________________________________________________________
+void ExceptionMatcherBenchmark::matchClass()
+{
+    QFETCH(int, count);
+
+    const ExceptionMatcher matcher(exceptions(count));
+
+    // more window classes than the matcher memoizes, so most lookups go through the patterns
+    QStringList windowClasses;
+    for (int i = 0; i < 1000; ++i) {
+        windowClasses.append(QStringLiteral("unknown%1 unknown").arg(i));
+    }
+
+    int next = 0;
+    QBENCHMARK {
+        const InternalSettingsPtr match = matcher.match(windowClasses.at(next), QString());
+        QVERIFY(!match);
+        next = (next + 1) % windowClasses.size();
+    }
+}
+
+//________________________________________________________________
+void ExceptionMatcherBenchmark::matchTitle_data()
+{
+    addRows();
+}
+
+//________________________________________________________________
+void ExceptionMatcherBenchmark::matchTitle()
+{
+    QFETCH(int, count);
+
+    const ExceptionMatcher matcher(exceptions(count));
+
+    // the window class is memoized but the title is not, every lookup matches it again
+    // lookups happen once per decoration and reconfigure, never on caption changes
+    int next = 0;
+    QBENCHMARK {
+        const InternalSettingsPtr match = matcher.match(QStringLiteral("konsole konsole"), QStringLiteral("document %1 - editor").arg(next++));
+        QVERIFY(!match);
+    }
+
+    if (count >= 4) {
+        QVERIFY(matcher.match(QStringLiteral("konsole konsole"), QStringLiteral("application3 - editor")));
+    }
+}
+
+QTEST_GUILESS_MAIN(ExceptionMatcherBenchmark)
+
+#include "exceptionmatcherbenchmark.moc"
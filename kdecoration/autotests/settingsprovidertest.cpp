@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "breezeexceptionlist.h"
+#include "breezesettingsprovider.h"
+
+#include <QStandardPaths>
+#include <QTest>
+#include <QThread>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+using namespace Breeze;
+
+class SettingsProviderTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void reconfigureWhileMatching();
+
+private:
+    //* write a configuration with a single exception, whose title bar setting depends on the pattern
+    static void writeExceptions(const QString &pattern);
+};
+
+//* window classes of the two configurations that are swapped back and forth
+static const QString s_firstClass = QStringLiteral("first");
+static const QString s_secondClass = QStringLiteral("second");
+
+//________________________________________________________________
+void SettingsProviderTest::writeExceptions(const QString &pattern)
+{
+    InternalSettingsPtr exception(new InternalSettings());
+    exception->setEnabled(true);
+    exception->setExceptionType(InternalSettings::ExceptionWindowClassName);
+    exception->setExceptionPattern(pattern);
+    exception->setHideTitleBar(pattern == s_firstClass);
+
+    KSharedConfig::Ptr config = KSharedConfig::openConfig(QStringLiteral("breezerc"));
+    ExceptionList({exception}).writeConfig(config);
+}
+
+//________________________________________________________________
+void SettingsProviderTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+
+    // the provider lives in the main thread, as with the decorations
+    writeExceptions(s_firstClass);
+    QVERIFY(SettingsProvider::self());
+}
+
+//________________________________________________________________
+void SettingsProviderTest::reconfigureWhileMatching()
+{
+    // Readers check that every snapshot they get is consistent: exactly one of
+    // the two window classes has an exception, with the matching settings.
+    std::atomic<bool> done{false};
+    std::atomic<int> lookups{0};
+    std::atomic<int> failures{0};
+
+    auto read = [&]() {
+        while (!done.load(std::memory_order_relaxed)) {
+            const auto snapshot = SettingsProvider::self()->snapshot();
+            const InternalSettingsPtr first = snapshot->exceptions.match(s_firstClass, QString());
+            const InternalSettingsPtr second = snapshot->exceptions.match(s_secondClass, QString());
+
+            const bool consistent = snapshot->defaultSettings && (first ? !second && first->hideTitleBar() : second && !second->hideTitleBar());
+            if (!consistent) {
+                failures.fetch_add(1, std::memory_order_relaxed);
+            }
+            lookups.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+
+    std::vector<std::unique_ptr<QThread>> readers;
+    for (int i = 0; i < qMax(2, QThread::idealThreadCount()); ++i) {
+        readers.emplace_back(QThread::create(read));
+        readers.back()->start();
+    }
+
+    // keep going until the readers got some work done, in case they were slow to start
+    int reconfigures = 0;
+    for (; reconfigures < 500 || lookups.load() < 1000; ++reconfigures) {
+        writeExceptions(reconfigures % 2 ? s_firstClass : s_secondClass);
+        SettingsProvider::self()->reconfigure();
+    }
+
+    done = true;
+    for (const auto &reader : readers) {
+        QVERIFY(reader->wait());
+    }
+
+    qDebug() << lookups.load() << "lookups while reconfiguring" << reconfigures << "times";
+    QCOMPARE(failures.load(), 0);
+}
+
+QTEST_GUILESS_MAIN(SettingsProviderTest)
+
+#include "settingsprovidertest.moc"
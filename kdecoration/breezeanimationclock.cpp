@@ -0,0 +1,184 @@
+/*
+ * SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "breezeanimationclock.h"
+
+#include <QVector>
+
+namespace Breeze
+{
+/**
+ * Drives all running ClockedAnimations.
+ *
+ * Being a QAbstractAnimation, the clock is ticked by Qt's animation timer, in
+ * step with every other animation of the compositor. It only runs while some
+ * animation does. That timer fires about every 16 milliseconds and is not
+ * driven by the compositor frames, so ticks are not aligned with vsync.
+ **/
+class AnimationClock : public QAbstractAnimation
+{
+public:
+    //* never finishes on its own
+    int duration() const override
+    {
+        return -1;
+    }
+
+    //*@name shared instance, alive as long as some animation exists
+    //@{
+    static void acquire();
+    static void release();
+
+    static AnimationClock *self()
+    {
+        return s_self;
+    }
+    //@}
+
+    //* start advancing the animation
+    void add(ClockedAnimation *animation);
+
+    //* stop advancing the animation
+    void remove(ClockedAnimation *animation);
+
+protected:
+    void updateCurrentTime(int currentTime) override;
+
+private:
+    //* running animations
+    QVector<ClockedAnimation *> m_animations;
+
+    //* time of the last tick
+    int m_lastTime = 0;
+
+    static AnimationClock *s_self;
+    static int s_animationCount;
+};
+
+AnimationClock *AnimationClock::s_self = nullptr;
+int AnimationClock::s_animationCount = 0;
+
+//__________________________________________________________________
+void AnimationClock::acquire()
+{
+    if (s_animationCount++ == 0) {
+        s_self = new AnimationClock();
+    }
+}
+
+//__________________________________________________________________
+void AnimationClock::release()
+{
+    if (--s_animationCount == 0) {
+        // the last animation may be destroyed from a callback, while the clock ticks
+        s_self->stop();
+        s_self->deleteLater();
+        s_self = nullptr;
+    }
+}
+
+//__________________________________________________________________
+void AnimationClock::add(ClockedAnimation *animation)
+{
+    if (m_animations.contains(animation)) {
+        return;
+    }
+
+    m_animations.append(animation);
+    if (state() != QAbstractAnimation::Running) {
+        m_lastTime = 0;
+        start();
+    }
+}
+
+//__________________________________________________________________
+void AnimationClock::remove(ClockedAnimation *animation)
+{
+    m_animations.removeOne(animation);
+    if (m_animations.isEmpty()) {
+        stop();
+    }
+}
+
+//__________________________________________________________________
+void AnimationClock::updateCurrentTime(int currentTime)
+{
+    const int elapsed = currentTime - m_lastTime;
+    m_lastTime = currentTime;
+
+    // callbacks may start or stop animations, only advance the ones still running
+    const auto animations = m_animations;
+    for (ClockedAnimation *animation : animations) {
+        if (m_animations.contains(animation)) {
+            animation->advance(elapsed);
+        }
+    }
+
+    m_animations.removeIf([](const ClockedAnimation *animation) {
+        return !animation->m_running;
+    });
+
+    if (m_animations.isEmpty()) {
+        stop();
+    }
+}
+
+//__________________________________________________________________
+ClockedAnimation::ClockedAnimation(const Callback &callback)
+    : m_callback(callback)
+{
+    AnimationClock::acquire();
+}
+
+//__________________________________________________________________
+ClockedAnimation::~ClockedAnimation()
+{
+    // an animation that finished earlier in the current tick is still listed by the clock
+    m_running = false;
+    AnimationClock::self()->remove(this);
+    AnimationClock::release();
+}
+
+//__________________________________________________________________
+void ClockedAnimation::start()
+{
+    const qreal value = this->value();
+    m_progress = m_direction == QAbstractAnimation::Forward ? 0 : 1;
+    m_running = true;
+    AnimationClock::self()->add(this);
+
+    if (this->value() != value) {
+        m_callback(this->value());
+    }
+}
+
+//__________________________________________________________________
+void ClockedAnimation::stop()
+{
+    if (!m_running) {
+        return;
+    }
+
+    m_running = false;
+    AnimationClock::self()->remove(this);
+}
+
+//__________________________________________________________________
+void ClockedAnimation::advance(int elapsed)
+{
+    const qreal step = m_duration > 0 ? qreal(elapsed) / m_duration : 1;
+    if (m_direction == QAbstractAnimation::Forward) {
+        m_progress = qMin<qreal>(1, m_progress + step);
+        m_running = m_progress < 1;
+    } else {
+        m_progress = qMax<qreal>(0, m_progress - step);
+        m_running = m_progress > 0;
+    }
+
+    m_callback(value());
+}
+
+}
@@ -0,0 +1,101 @@
+/*
+ * SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#pragma once
+
+#include <QAbstractAnimation>
+#include <QEasingCurve>
+
+#include <functional>
+
+namespace Breeze
+{
+/**
+ * Animation of a value from 0 to 1, for decorations and their buttons.
+ *
+ * Unlike QVariantAnimation, it is not a QObject. All running animations are
+ * advanced together by a clock shared by the whole plugin, once per tick of
+ * Qt's animation timer, so their repaints are requested in the same pass.
+ **/
+class ClockedAnimation
+{
+public:
+    //* called with the eased value whenever it changes
+    using Callback = std::function<void(qreal)>;
+
+    //* constructor
+    explicit ClockedAnimation(const Callback &callback);
+
+    //* destructor
+    ~ClockedAnimation();
+
+    ClockedAnimation(const ClockedAnimation &) = delete;
+    ClockedAnimation &operator=(const ClockedAnimation &) = delete;
+
+    //*@name accessors
+    //@{
+    int duration() const
+    {
+        return m_duration;
+    }
+
+    QAbstractAnimation::State state() const
+    {
+        return m_running ? QAbstractAnimation::Running : QAbstractAnimation::Stopped;
+    }
+
+    //* current eased value
+    qreal value() const
+    {
+        return m_easingCurve.valueForProgress(m_progress);
+    }
+    //@}
+
+    //*@name modifiers
+    //@{
+    void setDuration(int duration)
+    {
+        m_duration = duration;
+    }
+
+    void setEasingCurve(const QEasingCurve &easingCurve)
+    {
+        m_easingCurve = easingCurve;
+    }
+
+    //* change the direction, a running animation turns around from where it is
+    void setDirection(QAbstractAnimation::Direction direction)
+    {
+        m_direction = direction;
+    }
+
+    //* start from the beginning, or from the end when running backward
+    void start();
+
+    //* stop where the animation is
+    void stop();
+    //@}
+
+private:
+    friend class AnimationClock;
+
+    //* move forward in time, stops running once the end is reached
+    void advance(int elapsed);
+
+    Callback m_callback;
+    QEasingCurve m_easingCurve;
+    QAbstractAnimation::Direction m_direction = QAbstractAnimation::Forward;
+
+    //* duration, in milliseconds
+    int m_duration = 250;
+
+    //* elapsed fraction of the duration
+    qreal m_progress = 0;
+
+    bool m_running = false;
+};
+
+}
@@ -10,9 +10,10 @@
 #include <KDecoration3/DecoratedWindow>
 #include <KIconLoader>
 
+#include <QCache>
 #include <QPainter>
 #include <QPainterPath>
-#include <QVariantAnimation>
+#include <QtMath>
 
 namespace Breeze
 {
@@ -20,19 +21,97 @@ using KDecoration3::ColorGroup;
 using KDecoration3::ColorRole;
 using KDecoration3::DecorationButtonType;
 
+//* everything the glyph of a button depends on
+struct GlyphKey {
+    DecorationButtonType type;
+    bool checked;
+    QRgb foreground;
+    QRgb background;
+    //* the center dot of OnAllDesktops falls back to the title bar color
+    QRgb titleBar;
+    QSizeF size;
+    qreal scale;
+
+    friend bool operator==(const GlyphKey &lhs, const GlyphKey &rhs)
+    {
+        return lhs.type == rhs.type && lhs.checked == rhs.checked && lhs.foreground == rhs.foreground && lhs.background == rhs.background
+            && lhs.titleBar == rhs.titleBar && lhs.size == rhs.size && lhs.scale == rhs.scale;
+    }
+
+    friend size_t qHash(const GlyphKey &key, size_t seed = 0)
+    {
+        size_t hash = qHash(static_cast<int>(key.type), seed);
+        hash = hash * 31 + qHash(key.checked);
+        hash = hash * 31 + qHash(key.foreground);
+        hash = hash * 31 + qHash(key.background);
+        hash = hash * 31 + qHash(key.titleBar);
+        hash = hash * 31 + qHash(key.size.width());
+        hash = hash * 31 + qHash(key.size.height());
+        return hash * 31 + qHash(key.scale);
+    }
+};
+
+//* rasterized glyphs shared by all buttons
+static QCache<GlyphKey, QImage> g_glyphs(256);
+
+//* everything the tinted window icon depends on
+struct MenuIconKey {
+    qint64 icon;
+    qint64 palette;
+    QRgb color;
+    QSize size;
+    qreal scale;
+
+    friend bool operator==(const MenuIconKey &lhs, const MenuIconKey &rhs)
+    {
+        return lhs.icon == rhs.icon && lhs.palette == rhs.palette && lhs.color == rhs.color && lhs.size == rhs.size && lhs.scale == rhs.scale;
+    }
+
+    friend size_t qHash(const MenuIconKey &key, size_t seed = 0)
+    {
+        size_t hash = qHash(key.icon, seed);
+        hash = hash * 31 + qHash(key.palette);
+        hash = hash * 31 + qHash(key.color);
+        hash = hash * 31 + qHash(key.size.width());
+        hash = hash * 31 + qHash(key.size.height());
+        return hash * 31 + qHash(key.scale);
+    }
+};
+
+/**
+ * Window icons, tinted with the font color of the title bar.
+ *
+ * Stored as images, since the cache outlives the application and its platform
+ * plugin, which pixmaps must not.
+ **/
+static QCache<MenuIconKey, QImage> g_menuIcons(64);
+
+/**
+ * Whether a coordinate, in device pixels, is on the pixel grid.
+ *
+ * Device transforms at fractional scales carry some floating point noise, which
+ * must not prevent blitting.
+ **/
+static bool isOnPixelGrid(qreal value)
+{
+    return qAbs(value - std::round(value)) < 1.0 / 256;
+}
+
+//* invalid colors are stored as fully transparent, which draws nothing either
+static QRgb glyphColor(const QColor &color)
+{
+    return color.isValid() ? color.rgba() : 0;
+}
+
 //__________________________________________________________________
 Button::Button(DecorationButtonType type, Decoration *decoration, QObject *parent)
     : DecorationButton(type, decoration, parent)
-    , m_animation(new QVariantAnimation(this))
+    , m_animation([this](qreal value) {
+        setOpacity(value);
+    })
 {
     // setup animation
-    // It is important start and end value are of the same type, hence 0.0 and not just 0
-    m_animation->setStartValue(0.0);
-    m_animation->setEndValue(1.0);
-    m_animation->setEasingCurve(QEasingCurve::InOutQuad);
-    connect(m_animation, &QVariantAnimation::valueChanged, this, [this](const QVariant &value) {
-        setOpacity(value.toReal());
-    });
+    m_animation.setEasingCurve(QEasingCurve::InOutQuad);
 
     // connections
     connect(decoration->window(), SIGNAL(iconChanged(QIcon)), this, SLOT(update()));
@@ -100,9 +179,7 @@ Button *Button::create(DecorationButtonType type, KDecoration3::Decoration *deco
 //__________________________________________________________________
 void Button::paint(QPainter *painter, const QRectF &repaintRegion)
 {
-    Q_UNUSED(repaintRegion)
-
-    if (!decoration()) {
+    if (!decoration() || !geometry().intersects(repaintRegion)) {
         return;
     }
 
@@ -111,16 +188,11 @@ void Button::paint(QPainter *painter, const QRectF &repaintRegion)
         const QRectF iconRect = geometry().marginsRemoved(m_padding);
         const auto c = decoration()->window();
         if (auto deco = qobject_cast<Decoration *>(decoration())) {
-            const QPalette activePalette = KIconLoader::global()->customPalette();
-            QPalette palette = c->palette();
-            palette.setColor(QPalette::WindowText, deco->fontColor());
-            KIconLoader::global()->setCustomPalette(palette);
-            c->icon().paint(painter, iconRect.toRect());
-            if (activePalette == QPalette()) {
-                KIconLoader::global()->resetPalette();
-            } else {
-                KIconLoader::global()->setCustomPalette(palette);
-            }
+            // same placement as QIcon::paint
+            const QImage image = menuIcon(deco, iconRect.toRect().size(), painter->device()->devicePixelRatioF());
+            QRect imageRect(QPoint(0, 0), image.deviceIndependentSize().toSize());
+            imageRect.moveCenter(iconRect.toRect().center());
+            painter->drawImage(imageRect, image);
         } else {
             c->icon().paint(painter, iconRect.toRect());
         }
@@ -129,13 +201,101 @@ void Button::paint(QPainter *painter, const QRectF &repaintRegion)
     case KDecoration3::DecorationButtonType::Spacer:
         break;
     default:
-        painter->save();
-        drawIcon(painter);
-        painter->restore();
+        if (!drawCachedIcon(painter)) {
+            painter->save();
+            drawIcon(painter);
+            painter->restore();
+        }
         break;
     }
 }
 
+//__________________________________________________________________
+QImage Button::menuIcon(Decoration *decoration, const QSize &size, qreal scale) const
+{
+    const auto c = decoration->window();
+    const QIcon icon = c->icon();
+
+    const QColor fontColor = decoration->fontColor();
+
+    // key on the palette before it gets modified, modifying it changes its cache key
+    const MenuIconKey key{icon.cacheKey(), c->palette().cacheKey(), fontColor.rgba(), size, scale};
+    if (const QImage *image = g_menuIcons.object(key)) {
+        return *image;
+    }
+
+    QPalette palette = c->palette();
+    palette.setColor(QPalette::WindowText, fontColor);
+
+    // the icon loader tints icons with its global palette, so it has to be swapped while loading
+    const QPalette activePalette = KIconLoader::global()->customPalette();
+    KIconLoader::global()->setCustomPalette(palette);
+    const QImage image = icon.pixmap(size, scale).toImage();
+    if (activePalette == QPalette()) {
+        KIconLoader::global()->resetPalette();
+    } else {
+        KIconLoader::global()->setCustomPalette(activePalette);
+    }
+
+    // the font color changes every frame of an animation, don't fill the cache with it
+    if (!decoration->isAnimating()) {
+        g_menuIcons.insert(key, new QImage(image));
+    }
+
+    return image;
+}
+
+//__________________________________________________________________
+bool Button::drawCachedIcon(QPainter *painter) const
+{
+    // colors change every frame of an animation, don't fill the cache with them
+    auto d = qobject_cast<Decoration *>(decoration());
+    if (!d || d->isAnimating() || m_animation.state() == QAbstractAnimation::Running) {
+        return false;
+    }
+
+    // glyphs can only be blitted if they land on the pixel grid
+    const QTransform transform = painter->deviceTransform();
+    if (transform.type() > QTransform::TxScale || !qFuzzyCompare(transform.m11(), transform.m22())) {
+        return false;
+    }
+
+    const QRectF rect = geometry().marginsRemoved(m_padding);
+    const QPointF position = transform.map(rect.topLeft());
+    if (!isOnPixelGrid(position.x()) || !isOnPixelGrid(position.y())) {
+        return false;
+    }
+
+    // glyphs rendered at scales that only differ by noise are the same
+    const qreal scale = std::round(transform.m11() * 1024) / 1024;
+    const GlyphKey key{type(),
+                       isChecked(),
+                       glyphColor(foregroundColor()),
+                       glyphColor(backgroundColor()),
+                       type() == DecorationButtonType::OnAllDesktops ? glyphColor(d->titleBarColor()) : 0,
+                       rect.size(),
+                       scale};
+
+    QImage *glyph = g_glyphs.object(key);
+    if (!glyph) {
+        glyph = new QImage(qCeil(rect.width() * scale), qCeil(rect.height() * scale), QImage::Format_ARGB32_Premultiplied);
+        glyph->fill(Qt::transparent);
+
+        QPainter glyphPainter(glyph);
+        glyphPainter.scale(scale, scale);
+        glyphPainter.translate(-rect.topLeft());
+        drawIcon(&glyphPainter);
+        glyphPainter.end();
+
+        g_glyphs.insert(key, glyph);
+    }
+
+    // blit at the exact device pixel the glyph is close to
+    const QPointF target = transform.inverted().map(QPointF(std::round(position.x()), std::round(position.y())));
+    painter->drawImage(QRectF(target, QSizeF(glyph->size()) / scale), *glyph);
+    return true;
+}
+
 //__________________________________________________________________
 void Button::drawIcon(QPainter *painter) const
 {
@@ -320,7 +480,7 @@ QColor Button::foregroundColor() const
                && isChecked()) {
         return d->titleBarColor();
 
-    } else if (m_animation->state() == QAbstractAnimation::Running) {
+    } else if (m_animation.state() == QAbstractAnimation::Running) {
         return KColorUtils::mix(d->fontColor(), d->titleBarColor(), m_opacity);
 
     } else if (isHovered()) {
@@ -354,7 +514,7 @@ QColor Button::backgroundColor() const
         return d->fontColor();
     } else if (type() == DecorationButtonType::ExcludeFromCapture && isChecked()) {
         return redColor;
-    } else if (m_animation->state() == QAbstractAnimation::Running) {
+    } else if (m_animation.state() == QAbstractAnimation::Running) {
         if (type() == DecorationButtonType::Close) {
             if (d->internalSettings()->outlineCloseButton()) {
                 return c->isActive() ? KColorUtils::mix(redColor, redColor.lighter(), m_opacity) : KColorUtils::mix(redColor.lighter(), redColor, m_opacity);
@@ -404,7 +564,7 @@ void Button::reconfigure()
         break;
     }
 
-    m_animation->setDuration(d->animationsDuration());
+    m_animation.setDuration(d->animationsDuration());
 }
 
 //__________________________________________________________________
@@ -415,9 +575,9 @@ void Button::updateAnimationState(bool hovered)
         return;
     }
 
-    m_animation->setDirection(hovered ? QAbstractAnimation::Forward : QAbstractAnimation::Backward);
-    if (m_animation->state() != QAbstractAnimation::Running) {
-        m_animation->start();
+    m_animation.setDirection(hovered ? QAbstractAnimation::Forward : QAbstractAnimation::Backward);
+    if (m_animation.state() != QAbstractAnimation::Running) {
+        m_animation.start();
     }
 }
 
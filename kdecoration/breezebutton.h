@@ -13,8 +13,6 @@
 #include <QHash>
 #include <QImage>
 
-class QVariantAnimation;
-
 namespace Breeze
 {
 class Button : public KDecoration3::DecorationButton
@@ -95,6 +93,12 @@ private:
     //* draw button icon
     void drawIcon(QPainter *) const;
 
+    //* blit the icon from the shared glyph cache, false if it has to be drawn instead
+    bool drawCachedIcon(QPainter *) const;
+
+    //* window icon tinted for the title bar, cached for all menu buttons
+    QImage menuIcon(Decoration *decoration, const QSize &size, qreal scale) const;
+
     //*@name colors
     //@{
     QColor foregroundColor() const;
@@ -102,7 +106,7 @@ private:
     //@}
 
     //* active state change animation
-    QVariantAnimation *m_animation;
+    ClockedAnimation m_animation;
 
     //* padding (for rendering)
     QMargins m_padding;
@@ -14,69 +14,34 @@
 #include "breezebutton.h"
 
 #include "breezeboxshadowrenderer.h"
+#include "breezeshadowcache.h"
+#include "breezeshadowparams.h"
 
 #include <KDecoration3/DecorationButtonGroup>
 #include <KDecoration3/DecorationShadow>
 #include <KDecoration3/ScaleHelpers>
 
 #include <KColorUtils>
-#include <KConfigGroup>
 #include <KPluginFactory>
-#include <KSharedConfig>
 
 #include <KColorScheme>
-#include <QDBusConnection>
+#include <QCache>
 #include <QDBusMessage>
 #include <QDBusPendingCallWatcher>
 #include <QDBusPendingReply>
+#include <QHash>
 #include <QPainter>
 #include <QPainterPath>
 #include <QTextStream>
 #include <QTimer>
+#include <QtMath>
 
 K_PLUGIN_FACTORY_WITH_JSON(BreezeDecoFactory, "breeze.json", registerPlugin<Breeze::Decoration>(); registerPlugin<Breeze::Button>();)
 
 namespace
 {
-struct ShadowParams {
-    ShadowParams()
-        : offset(QPoint(0, 0))
-        , radius(0)
-        , opacity(0)
-    {
-    }
-
-    ShadowParams(const QPoint &offset, int radius, qreal opacity)
-        : offset(offset)
-        , radius(radius)
-        , opacity(opacity)
-    {
-    }
-
-    QPoint offset;
-    int radius;
-    qreal opacity;
-};
-
-struct CompositeShadowParams {
-    CompositeShadowParams() = default;
-
-    CompositeShadowParams(const QPoint &offset, const ShadowParams &shadow1, const ShadowParams &shadow2)
-        : offset(offset)
-        , shadow1(shadow1)
-        , shadow2(shadow2)
-    {
-    }
-
-    bool isNone() const
-    {
-        return qMax(shadow1.radius, shadow2.radius) == 0;
-    }
-
-    QPoint offset;
-    ShadowParams shadow1;
-    ShadowParams shadow2;
-};
+using Breeze::CompositeShadowParams;
+using Breeze::ShadowParams;
 
 const CompositeShadowParams s_shadowParams[] = {
     // None
@@ -118,17 +83,169 @@ using KDecoration3::ColorRole;
 
 //________________________________________________________________
 static int g_sDecoCount = 0;
-static int g_shadowSizeEnum = InternalSettings::ShadowLarge;
-static int g_shadowStrength = 255;
-static QColor g_shadowColor = Qt::black;
-static std::shared_ptr<KDecoration3::DecorationShadow> g_sShadow;
-static std::shared_ptr<KDecoration3::DecorationShadow> g_sShadowInactive;
+
+//* number of shadow strengths between inactive and active windows, including both
+static const int g_shadowLadderSteps = 16;
+
+static int shadowLadderStep(qreal opacity)
+{
+    return qRound(opacity * (g_shadowLadderSteps - 1));
+}
+
+//* everything a decoration shadow depends on
+struct DecorationShadowKey {
+    int size;
+    QRgb color;
+    int strength;
+    qreal cornerRadius;
+    int step;
+
+    friend bool operator==(const DecorationShadowKey &lhs, const DecorationShadowKey &rhs)
+    {
+        return lhs.size == rhs.size && lhs.color == rhs.color && lhs.strength == rhs.strength && lhs.cornerRadius == rhs.cornerRadius && lhs.step == rhs.step;
+    }
+
+    friend size_t qHash(const DecorationShadowKey &key, size_t seed = 0)
+    {
+        size_t hash = qHash(key.size, seed);
+        hash = hash * 31 + qHash(key.color);
+        hash = hash * 31 + qHash(key.strength);
+        hash = hash * 31 + qHash(key.cornerRadius);
+        return hash * 31 + qHash(key.step);
+    }
+};
+
+//* shadows shared by all decorations, an entry expires when no decoration uses it anymore
+static QHash<DecorationShadowKey, std::weak_ptr<KDecoration3::DecorationShadow>> g_shadows;
+
+//* outline of the title bar background
+enum class TitleBarShape {
+    Rectangle,
+    Rounded,
+    TopRounded,
+};
+
+//* everything the title bar background depends on, except for its width
+struct TitleBarKey {
+    qreal height;
+    qreal cornerRadius;
+    QRgb color;
+    bool gradient;
+    TitleBarShape shape;
+    qreal scale;
+
+    friend bool operator==(const TitleBarKey &lhs, const TitleBarKey &rhs)
+    {
+        return lhs.height == rhs.height && lhs.cornerRadius == rhs.cornerRadius && lhs.color == rhs.color && lhs.gradient == rhs.gradient
+            && lhs.shape == rhs.shape && lhs.scale == rhs.scale;
+    }
+
+    friend size_t qHash(const TitleBarKey &key, size_t seed = 0)
+    {
+        size_t hash = qHash(key.height, seed);
+        hash = hash * 31 + qHash(key.cornerRadius);
+        hash = hash * 31 + qHash(key.color);
+        hash = hash * 31 + qHash(key.gradient);
+        hash = hash * 31 + qHash(static_cast<int>(key.shape));
+        return hash * 31 + qHash(key.scale);
+    }
+};
+
+//* title bar backgrounds shared by all decorations
+static QCache<TitleBarKey, QImage> g_titleBarBackgrounds(64);
+
+//* paint the title bar background in the given rect
+static void paintTitleBarBackground(QPainter *painter, const QRectF &rect, const TitleBarKey &key)
+{
+    const QColor color = QColor::fromRgba(key.color);
+
+    QBrush frontBrush(color);
+    const QBrush backBrush(color);
+
+    // render a linear gradient on title area
+    if (key.gradient) {
+        QLinearGradient gradient(0, 0, 0, rect.height());
+        gradient.setColorAt(0.0, color.lighter(120));
+        gradient.setColorAt(0.8, color);
+
+        frontBrush = gradient;
+    }
+
+    painter->save();
+    painter->setPen(Qt::NoPen);
+
+    switch (key.shape) {
+    case TitleBarShape::Rectangle:
+        painter->setBrush(backBrush);
+        painter->drawRect(rect);
+
+        painter->setBrush(frontBrush);
+        painter->drawRect(rect);
+        break;
+
+    case TitleBarShape::Rounded:
+        painter->setBrush(backBrush);
+        painter->drawRoundedRect(rect, key.cornerRadius, key.cornerRadius);
+
+        painter->setBrush(frontBrush);
+        painter->drawRoundedRect(rect, key.cornerRadius, key.cornerRadius);
+        break;
+
+    case TitleBarShape::TopRounded: {
+        painter->setClipRect(rect, Qt::IntersectClip);
+
+        auto drawThe = [&key, painter](const QRectF &r) {
+            painter->drawRoundedRect(r, key.cornerRadius, key.cornerRadius);
+            // remove the rounding on the bottom
+            painter->drawRect(QRectF(r.bottomLeft() - QPointF(0, key.cornerRadius), r.bottomRight()));
+        };
+
+        painter->setBrush(backBrush);
+        drawThe(rect);
+
+        painter->setBrush(frontBrush);
+        drawThe(rect);
+        break;
+    }
+    }
+
+    painter->restore();
+}
+
+/**
+ * Rasterize the title bar background of a window that is just wide enough for its corners.
+ *
+ * The image holds the left corner, a 1 pixel wide strip and the right corner, in
+ * device pixels. The strip gets stretched to the width of the window.
+ **/
+static QImage renderTitleBarBackground(const TitleBarKey &key)
+{
+    const int capWidth = key.shape == TitleBarShape::Rectangle ? 0 : qCeil(key.cornerRadius * key.scale);
+
+    QImage image(2 * capWidth + 1, qCeil(key.height * key.scale), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.scale(key.scale, key.scale);
+    paintTitleBarBackground(&painter, QRectF(0, 0, image.width() / key.scale, key.height), key);
+
+    return image;
+}
 
 //________________________________________________________________
 Decoration::Decoration(QObject *parent, const QVariantList &args)
     : KDecoration3::Decoration(parent, args)
-    , m_animation(new QVariantAnimation(this))
-    , m_shadowAnimation(new QVariantAnimation(this))
+    , m_animation([this](qreal value) {
+        setOpacity(value);
+    })
+    , m_shadowAnimation([this](qreal value) {
+        const int previousStep = shadowLadderStep(m_shadowOpacity);
+        m_shadowOpacity = value;
+        if (shadowLadderStep(m_shadowOpacity) != previousStep) {
+            updateShadow();
+        }
+    })
 {
     g_sDecoCount++;
 }
@@ -138,8 +255,8 @@ Decoration::~Decoration()
 {
     g_sDecoCount--;
     if (g_sDecoCount == 0) {
-        // last deco destroyed, clean up shadow
-        g_sShadow.reset();
+        // last deco destroyed, clean up shadows
+        g_shadows.clear();
     }
 }
 
@@ -158,7 +275,7 @@ QColor Decoration::titleBarColor() const
 {
     if (hideTitleBar()) {
         return window()->color(ColorGroup::Inactive, ColorRole::TitleBar);
-    } else if (m_animation->state() == QAbstractAnimation::Running) {
+    } else if (m_animation.state() == QAbstractAnimation::Running) {
         return KColorUtils::mix(window()->color(ColorGroup::Inactive, ColorRole::TitleBar),
                                 window()->color(ColorGroup::Active, ColorRole::TitleBar),
                                 m_opacity);
@@ -170,7 +287,7 @@ QColor Decoration::titleBarColor() const
 //________________________________________________________________
 QColor Decoration::fontColor() const
 {
-    if (m_animation->state() == QAbstractAnimation::Running) {
+    if (m_animation.state() == QAbstractAnimation::Running) {
         return KColorUtils::mix(window()->color(ColorGroup::Inactive, ColorRole::Foreground),
                                 window()->color(ColorGroup::Active, ColorRole::Foreground),
                                 m_opacity);
@@ -183,31 +300,9 @@ QColor Decoration::fontColor() const
 bool Decoration::init()
 {
     // active state change animation
-    // It is important start and end value are of the same type, hence 0.0 and not just 0
-    m_animation->setStartValue(0.0);
-    m_animation->setEndValue(1.0);
     // Linear to have the same easing as Breeze animations
-    m_animation->setEasingCurve(QEasingCurve::Linear);
-    connect(m_animation, &QVariantAnimation::valueChanged, this, [this](const QVariant &value) {
-        setOpacity(value.toReal());
-    });
-
-    m_shadowAnimation->setStartValue(0.0);
-    m_shadowAnimation->setEndValue(1.0);
-    m_shadowAnimation->setEasingCurve(QEasingCurve::OutCubic);
-    connect(m_shadowAnimation, &QVariantAnimation::valueChanged, this, [this](const QVariant &value) {
-        m_shadowOpacity = value.toReal();
-        updateShadow();
-    });
-
-    // use DBus connection to update on breeze configuration change
-    auto dbus = QDBusConnection::sessionBus();
-    dbus.connect(QString(),
-                 QStringLiteral("/KGlobalSettings"),
-                 QStringLiteral("org.kde.KGlobalSettings"),
-                 QStringLiteral("notifyChange"),
-                 this,
-                 SLOT(reconfigure()));
+    m_animation.setEasingCurve(QEasingCurve::Linear);
+    m_shadowAnimation.setEasingCurve(QEasingCurve::OutCubic);
 
     reconfigure();
     updateTitleBar();
@@ -215,19 +310,32 @@ bool Decoration::init()
     connect(s.get(), &KDecoration3::DecorationSettings::borderSizeChanged, this, &Decoration::recalculateBorders);
 
     // a change in font might cause the borders to change
-    connect(s.get(), &KDecoration3::DecorationSettings::fontChanged, this, &Decoration::recalculateBorders);
+    connect(s.get(), &KDecoration3::DecorationSettings::fontChanged, this, [this]() {
+        m_fontHeight = -1;
+        recalculateBorders();
+    });
     connect(s.get(), &KDecoration3::DecorationSettings::spacingChanged, this, &Decoration::recalculateBorders);
 
     // buttons
-    connect(s.get(), &KDecoration3::DecorationSettings::spacingChanged, this, &Decoration::updateButtonsGeometryDelayed);
-    connect(s.get(), &KDecoration3::DecorationSettings::decorationButtonsLeftChanged, this, &Decoration::updateButtonsGeometryDelayed);
-    connect(s.get(), &KDecoration3::DecorationSettings::decorationButtonsRightChanged, this, &Decoration::updateButtonsGeometryDelayed);
+    connect(s.get(), &KDecoration3::DecorationSettings::spacingChanged, this, [this]() {
+        scheduleLayout(LayoutButtons);
+    });
+    connect(s.get(), &KDecoration3::DecorationSettings::decorationButtonsLeftChanged, this, [this]() {
+        scheduleLayout(LayoutButtons);
+    });
+    connect(s.get(), &KDecoration3::DecorationSettings::decorationButtonsRightChanged, this, [this]() {
+        scheduleLayout(LayoutButtons);
+    });
 
     // full reconfiguration
-    connect(s.get(), &KDecoration3::DecorationSettings::reconfigured, this, &Decoration::reconfigure);
-    connect(s.get(), &KDecoration3::DecorationSettings::reconfigured, SettingsProvider::self(), &SettingsProvider::reconfigure, Qt::UniqueConnection);
-    connect(s.get(), &KDecoration3::DecorationSettings::reconfigured, this, &Decoration::updateButtonsGeometryDelayed);
+    // the settings provider reads the configuration once for all decorations, then notifies them
+    connect(s.get(), &KDecoration3::DecorationSettings::reconfigured, SettingsProvider::self(), &SettingsProvider::scheduleReconfigure, Qt::UniqueConnection);
+    connect(SettingsProvider::self(), &SettingsProvider::reconfigured, this, &Decoration::reconfigure);
+    connect(SettingsProvider::self(), &SettingsProvider::reconfigured, this, [this]() {
+        scheduleLayout(LayoutButtons);
+    });
 
+    // borders are updated right away, the compositor sizes the window from them
     connect(window(), &KDecoration3::DecoratedWindow::activeChanged, this, &Decoration::recalculateBorders);
     connect(window(), &KDecoration3::DecoratedWindow::adjacentScreenEdgesChanged, this, &Decoration::recalculateBorders);
     connect(window(), &KDecoration3::DecoratedWindow::maximizedHorizontallyChanged, this, &Decoration::recalculateBorders);
@@ -239,16 +347,24 @@ bool Decoration::init()
     });
 
     connect(window(), &KDecoration3::DecoratedWindow::activeChanged, this, &Decoration::updateAnimationState);
-    connect(this, &KDecoration3::Decoration::bordersChanged, this, &Decoration::updateTitleBar);
-    connect(window(), &KDecoration3::DecoratedWindow::adjacentScreenEdgesChanged, this, &Decoration::updateTitleBar);
-    connect(window(), &KDecoration3::DecoratedWindow::widthChanged, this, &Decoration::updateTitleBar);
-    connect(window(), &KDecoration3::DecoratedWindow::maximizedChanged, this, &Decoration::updateTitleBar);
-    connect(window(), &KDecoration3::DecoratedWindow::maximizedChanged, this, &Decoration::setOpaque);
 
-    connect(window(), &KDecoration3::DecoratedWindow::widthChanged, this, &Decoration::updateButtonsGeometry);
-    connect(window(), &KDecoration3::DecoratedWindow::maximizedChanged, this, &Decoration::updateButtonsGeometry);
-    connect(window(), &KDecoration3::DecoratedWindow::adjacentScreenEdgesChanged, this, &Decoration::updateButtonsGeometry);
-    connect(window(), &KDecoration3::DecoratedWindow::shadedChanged, this, &Decoration::updateButtonsGeometry);
+    // geometry changes are laid out right away, so that the damage they cause is painted with the new layout
+    connect(this, &KDecoration3::Decoration::bordersChanged, this, [this]() {
+        flushLayout(LayoutTitleBar);
+    });
+    connect(window(), &KDecoration3::DecoratedWindow::adjacentScreenEdgesChanged, this, [this]() {
+        flushLayout(LayoutTitleBar | LayoutButtons);
+    });
+    connect(window(), &KDecoration3::DecoratedWindow::widthChanged, this, [this]() {
+        flushLayout(LayoutTitleBar | LayoutButtons);
+    });
+    connect(window(), &KDecoration3::DecoratedWindow::maximizedChanged, this, [this]() {
+        flushLayout(LayoutTitleBar | LayoutButtons);
+    });
+    connect(window(), &KDecoration3::DecoratedWindow::shadedChanged, this, [this]() {
+        flushLayout(LayoutButtons);
+    });
+    connect(window(), &KDecoration3::DecoratedWindow::maximizedChanged, this, &Decoration::setOpaque);
 
     connect(window(), &KDecoration3::DecoratedWindow::nextScaleChanged, this, &Decoration::updateScale);
 
@@ -273,21 +389,21 @@ void Decoration::updateTitleBar()
 //________________________________________________________________
 void Decoration::updateAnimationState()
 {
-    if (m_shadowAnimation->duration() > 0) {
-        m_shadowAnimation->setDirection(window()->isActive() ? QAbstractAnimation::Forward : QAbstractAnimation::Backward);
-        m_shadowAnimation->setEasingCurve(window()->isActive() ? QEasingCurve::OutCubic : QEasingCurve::InCubic);
-        if (m_shadowAnimation->state() != QAbstractAnimation::Running) {
-            m_shadowAnimation->start();
+    if (m_shadowAnimation.duration() > 0) {
+        m_shadowAnimation.setDirection(window()->isActive() ? QAbstractAnimation::Forward : QAbstractAnimation::Backward);
+        m_shadowAnimation.setEasingCurve(window()->isActive() ? QEasingCurve::OutCubic : QEasingCurve::InCubic);
+        if (m_shadowAnimation.state() != QAbstractAnimation::Running) {
+            m_shadowAnimation.start();
         }
 
     } else {
         updateShadow();
     }
 
-    if (m_animation->duration() > 0) {
-        m_animation->setDirection(window()->isActive() ? QAbstractAnimation::Forward : QAbstractAnimation::Backward);
-        if (m_animation->state() != QAbstractAnimation::Running) {
-            m_animation->start();
+    if (m_animation.duration() > 0) {
+        m_animation.setDirection(window()->isActive() ? QAbstractAnimation::Forward : QAbstractAnimation::Backward);
+        if (m_animation.state() != QAbstractAnimation::Running) {
+            m_animation.start();
         }
 
     } else {
@@ -375,17 +491,15 @@ void Decoration::reconfigure()
     setScaledCornerRadius();
 
     // animation
+    const qreal animationDurationFactor = SettingsProvider::self()->animationDurationFactor();
 
-    KSharedConfig::Ptr config = KSharedConfig::openConfig();
-    const KConfigGroup cg(config, QStringLiteral("KDE"));
-
-    m_animation->setDuration(0);
+    m_animation.setDuration(0);
     // Syncing anis between client and decoration is troublesome, so we're not using
     // any animations right now.
-    // m_animation->setDuration( cg.readEntry("AnimationDurationFactor", 1.0f) * 100.0f );
+    // m_animation.setDuration( animationDurationFactor * 100.0f );
 
     // But the shadow is fine to animate like this!
-    m_shadowAnimation->setDuration(cg.readEntry("AnimationDurationFactor", 1.0f) * 100.0f);
+    m_shadowAnimation.setDuration(animationDurationFactor * 100.0f);
 
     // borders
     recalculateBorders();
@@ -404,8 +518,7 @@ QMarginsF Decoration::bordersFor(qreal scale) const
     if (hideTitleBar()) {
         top = bottom;
     } else {
-        QFontMetrics fm(settings()->font());
-        top += KDecoration3::snapToPixelGrid(std::max(fm.height(), buttonSize()), scale);
+        top += KDecoration3::snapToPixelGrid(std::max(fontHeight(), buttonSize()), scale);
 
         // padding below
         const int baseSize = settings()->smallSpacing();
@@ -417,6 +530,16 @@ QMarginsF Decoration::bordersFor(qreal scale) const
     return QMarginsF(left, top, right, bottom);
 }
 
+//________________________________________________________________
+int Decoration::fontHeight() const
+{
+    if (m_fontHeight < 0) {
+        m_fontHeight = QFontMetrics(settings()->font()).height();
+    }
+
+    return m_fontHeight;
+}
+
 void Decoration::recalculateBorders()
 {
     setBorders(bordersFor(window()->nextScale()));
@@ -502,9 +625,39 @@ void Decoration::createButtons()
 }
 
 //________________________________________________________________
-void Decoration::updateButtonsGeometryDelayed()
+void Decoration::scheduleLayout(LayoutFlags flags)
+{
+    if (!m_dirtyLayout) {
+        QTimer::singleShot(0, this, &Decoration::updateLayout);
+    }
+    m_dirtyLayout |= flags;
+}
+
+//________________________________________________________________
+void Decoration::flushLayout(LayoutFlags flags)
 {
-    QTimer::singleShot(0, this, &Decoration::updateButtonsGeometry);
+    m_dirtyLayout |= flags;
+    updateLayout();
+}
+
+//________________________________________________________________
+void Decoration::updateLayout()
+{
+    // a geometry change may already have flushed what was scheduled
+    if (!m_dirtyLayout) {
+        return;
+    }
+
+    const LayoutFlags flags = m_dirtyLayout;
+    m_dirtyLayout = {};
+
+    if (flags & LayoutTitleBar) {
+        updateTitleBar();
+    }
+
+    if (flags & LayoutButtons) {
+        updateButtonsGeometry();
+    }
 }
 
 //________________________________________________________________
@@ -580,11 +733,16 @@ void Decoration::updateButtonsGeometry()
 //________________________________________________________________
 void Decoration::paint(QPainter *painter, const QRectF &repaintRegion)
 {
-    // TODO: optimize based on repaintRegion
     auto s = settings();
+
+    // only the damaged part needs painting
+    painter->save();
+    painter->setClipRect(repaintRegion, Qt::IntersectClip);
+
     // paint background
-    if (!window()->isShaded()) {
-        painter->fillRect(rect(), Qt::transparent);
+    const QRectF frameRect = hideTitleBar() ? rect() : QRectF(0, borderTop(), size().width(), size().height() - borderTop());
+    if (!window()->isShaded() && frameRect.intersects(repaintRegion)) {
+        painter->fillRect(rect().intersected(repaintRegion), Qt::transparent);
         painter->save();
         painter->setRenderHint(QPainter::Antialiasing);
         painter->setPen(Qt::NoPen);
@@ -592,7 +750,7 @@ void Decoration::paint(QPainter *painter, const QRectF &repaintRegion)
 
         // clip away the top part
         if (!hideTitleBar()) {
-            painter->setClipRect(QRectF(0, borderTop(), size().width(), size().height() - borderTop()), Qt::IntersectClip);
+            painter->setClipRect(frameRect, Qt::IntersectClip);
         }
 
         if (s->isAlphaChannelSupported()) {
@@ -612,7 +770,8 @@ void Decoration::paint(QPainter *painter, const QRectF &repaintRegion)
         paintTitleBar(painter, repaintRegion);
     }
 
-    if (hasBorders() && !s->isAlphaChannelSupported()) {
+    // the outline is only damaged if the region reaches the outer pixels
+    if (hasBorders() && !s->isAlphaChannelSupported() && !rect().adjusted(1, 1, -1, -1).contains(repaintRegion)) {
         const QColor borderColor = borderOutline().color();
         if (borderColor.alphaF() > 0) {
             painter->save();
@@ -623,75 +782,105 @@ void Decoration::paint(QPainter *painter, const QRectF &repaintRegion)
             painter->restore();
         }
     }
+
+    painter->restore();
 }
 
 //________________________________________________________________
 void Decoration::paintTitleBar(QPainter *painter, const QRectF &repaintRegion)
 {
-    QRectF rect(QPointF(0, 0), QSizeF(size().width(), borderTop()));
-    QBrush frontBrush;
-    QBrush backBrush(this->titleBarColor());
+    const QRectF rect(QPointF(0, 0), QSizeF(size().width(), borderTop()));
 
     if (!rect.intersects(repaintRegion)) {
         return;
     }
 
-    painter->save();
-    painter->setPen(Qt::NoPen);
-
-    // render a linear gradient on title area
-    if (window()->isActive() && m_internalSettings->drawBackgroundGradient()) {
-        QLinearGradient gradient(0, 0, 0, rect.height());
-        gradient.setColorAt(0.0, titleBarColor().lighter(120));
-        gradient.setColorAt(0.8, titleBarColor());
-
-        frontBrush = gradient;
-
-    } else {
-        frontBrush = titleBarColor();
+    TitleBarShape shape = TitleBarShape::TopRounded;
+    if (isMaximized() || !settings()->isAlphaChannelSupported()) {
+        shape = TitleBarShape::Rectangle;
+    } else if (window()->isShaded()) {
+        shape = TitleBarShape::Rounded;
+    }
 
-        painter->setBrush(titleBarColor());
+    const TitleBarKey key{rect.height(),
+                          m_scaledCornerRadius,
+                          titleBarColor().rgba(),
+                          window()->isActive() && m_internalSettings->drawBackgroundGradient(),
+                          shape,
+                          painter->device()->devicePixelRatioF() * painter->transform().m22()};
+
+    // The background is rasterized once for all windows with the same title bar, except
+    // while colors animate, as every frame would need a new one.
+    QImage *background = nullptr;
+    if (m_animation.state() != QAbstractAnimation::Running) {
+        background = g_titleBarBackgrounds.object(key);
+        if (!background) {
+            background = new QImage(renderTitleBarBackground(key));
+            g_titleBarBackgrounds.insert(key, background);
+        }
     }
 
-    if (isMaximized() || !settings()->isAlphaChannelSupported()) {
-        painter->setBrush(backBrush);
-        painter->drawRect(rect);
+    const int capPixels = background ? (background->width() - 1) / 2 : 0;
+    const qreal capWidth = capPixels / key.scale;
 
-        painter->setBrush(frontBrush);
-        painter->drawRect(rect);
-    } else if (window()->isShaded()) {
-        painter->setBrush(backBrush);
-        painter->drawRoundedRect(rect, m_scaledCornerRadius, m_scaledCornerRadius);
+    if (background && rect.width() >= 2 * capWidth + 1) {
+        const qreal height = background->height() / key.scale;
 
-        painter->setBrush(frontBrush);
-        painter->drawRoundedRect(rect, m_scaledCornerRadius, m_scaledCornerRadius);
-
-    } else {
+        painter->save();
         painter->setClipRect(rect, Qt::IntersectClip);
-
-        auto drawThe = [this, painter](const QRectF &r) {
-            painter->drawRoundedRect(r, m_scaledCornerRadius, m_scaledCornerRadius);
-            // remove the rounding on the bottom
-            painter->drawRect(QRectF(r.bottomLeft() - QPointF(0, m_scaledCornerRadius), r.bottomRight()));
+        painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
+
+        // At fractional scales the edges of the window may fall between two device pixels.
+        // Both caps are moved to the closest device pixel boundary, in device coordinates so
+        // that the translation of the painter is accounted for. The caps are blitted without
+        // resampling, and the stretched strip covers whole device pixels between them,
+        // without a seam or a half covered column.
+        const QTransform transform = painter->transform();
+        const qreal devicePixelRatio = painter->device()->devicePixelRatioF();
+        auto snapToDevicePixels = [&transform, devicePixelRatio](qreal x) {
+            const qreal deviceX = std::round((transform.m11() * x + transform.dx()) * devicePixelRatio);
+            return (deviceX / devicePixelRatio - transform.dx()) / transform.m11();
         };
 
-        painter->setBrush(backBrush);
-        drawThe(rect);
+        const qreal leftCapStart = snapToDevicePixels(0);
+        const qreal leftCapEnd = leftCapStart + capWidth;
+        const qreal rightCapStart = snapToDevicePixels(rect.width() - capWidth);
 
-        painter->setBrush(frontBrush);
-        drawThe(rect);
-    }
+        painter->drawImage(QRectF(leftCapStart, 0, capWidth, height), *background, QRectF(0, 0, capPixels, background->height()));
+        painter->drawImage(QRectF(leftCapEnd, 0, rightCapStart - leftCapEnd, height), *background, QRectF(capPixels, 0, 1, background->height()));
+        painter->drawImage(QRectF(rightCapStart, 0, capWidth, height), *background, QRectF(capPixels + 1, 0, capPixels, background->height()));
 
-    painter->restore();
+        painter->restore();
+    } else {
+        paintTitleBarBackground(painter, rect, key);
+    }
 
     // draw caption
-    painter->setFont(settings()->font());
-    painter->setPen(fontColor());
     const auto [captionRectangle, alignment] = captionRect();
-    const QString caption = painter->fontMetrics().elidedText(window()->caption(), Qt::ElideMiddle, captionRectangle.width());
-    painter->drawText(captionRectangle, alignment | Qt::TextSingleLine, caption);
+    if (captionRectangle.intersects(repaintRegion)) {
+        painter->setFont(settings()->font());
+        painter->setPen(fontColor());
+
+        // only the color may change between paints, the caption is laid out once
+        const QStaticText &caption = captionText(painter, captionRectangle.width());
+
+        // align the caption the way drawText() does, which rounds the size of the text up to full pixels first
+        const QSizeF captionSize(qCeil(caption.size().width()), qCeil(caption.size().height()));
+
+        QPointF position(captionRectangle.topLeft());
+        if (alignment & Qt::AlignVCenter) {
+            position.setY(captionRectangle.top() + (captionRectangle.height() - captionSize.height()) / 2);
+        }
+        if (alignment & Qt::AlignRight) {
+            position.setX(captionRectangle.right() - captionSize.width());
+        } else if (alignment & Qt::AlignHCenter) {
+            position.setX(captionRectangle.center().x() - captionSize.width() / 2);
+        }
+
+        painter->drawStaticText(position, caption);
+    }
 
-    // draw all buttons
+    // draw all buttons, each of them skips itself if it isn't damaged
     m_leftButtons->paint(painter, repaintRegion);
     m_rightButtons->paint(painter, repaintRegion);
 }
@@ -755,11 +944,8 @@ QPair<QRectF, Qt::Alignment> Decoration::captionRect() const
         case InternalSettings::AlignCenterFullWidth: {
             // full caption rect
             const QRectF fullRect = QRect(0, yOffset, size().width(), captionHeight());
-            QRectF boundingRect(settings()->fontMetrics().boundingRect(window()->caption()));
-
             // text bounding rect
-            boundingRect.setTop(yOffset);
-            boundingRect.setHeight(captionHeight());
+            QRectF boundingRect(0, yOffset, captionWidth(), captionHeight());
             boundingRect.moveLeft((size().width() - boundingRect.width()) / 2);
 
             if (boundingRect.left() < leftOffset) {
@@ -775,30 +961,77 @@ QPair<QRectF, Qt::Alignment> Decoration::captionRect() const
 }
 
 //________________________________________________________________
-void Decoration::updateShadow()
+qreal Decoration::captionWidth() const
 {
-    auto s = settings();
+    const QString caption = window()->caption();
+    const QFont font = settings()->font();
+    if (m_captionLayout.caption != caption || m_captionLayout.font != font) {
+        m_captionLayout.caption = caption;
+        m_captionLayout.font = font;
+        m_captionLayout.fullWidth = settings()->fontMetrics().boundingRect(caption).width();
+        m_captionLayout.availableWidth = -1;
+    }
+    return m_captionLayout.fullWidth;
+}
 
-    // Animated case, no cached shadow object
-    if ((m_shadowAnimation->state() == QAbstractAnimation::Running) && (m_shadowOpacity != 0.0) && (m_shadowOpacity != 1.0)) {
-        setShadow(createShadowObject(0.5 + m_shadowOpacity * 0.5));
-        return;
+//________________________________________________________________
+const QStaticText &Decoration::captionText(QPainter *painter, qreal availableWidth)
+{
+    // makes sure the layout belongs to the current caption
+    captionWidth();
+
+    // the prepared glyph positions depend on the device pixel ratio, which the transform does not include
+    const qreal devicePixelRatio = painter->device()->devicePixelRatioF();
+    if (m_captionLayout.availableWidth != availableWidth || m_captionLayout.devicePixelRatio != devicePixelRatio) {
+        m_captionLayout.availableWidth = availableWidth;
+        m_captionLayout.devicePixelRatio = devicePixelRatio;
+
+        QString caption = painter->fontMetrics().elidedText(m_captionLayout.caption, Qt::ElideMiddle, availableWidth);
+        caption.replace(QLatin1Char('\n'), QLatin1Char(' '));
+
+        m_captionLayout.text = QStaticText(caption);
+        m_captionLayout.text.setTextFormat(Qt::PlainText);
+        m_captionLayout.text.prepare(painter->transform(), m_captionLayout.font);
     }
 
-    if (g_shadowSizeEnum != m_internalSettings->shadowSize() || g_shadowStrength != m_internalSettings->shadowStrength()
-        || g_shadowColor != m_internalSettings->shadowColor()) {
-        g_sShadow.reset();
-        g_sShadowInactive.reset();
-        g_shadowSizeEnum = m_internalSettings->shadowSize();
-        g_shadowStrength = m_internalSettings->shadowStrength();
-        g_shadowColor = m_internalSettings->shadowColor();
+    return m_captionLayout.text;
+}
+
+//________________________________________________________________
+void Decoration::updateShadow()
+{
+    qreal opacity = window()->isActive() ? 1.0 : 0.0;
+    if ((m_shadowAnimation.state() == QAbstractAnimation::Running) && (m_shadowOpacity != 0.0) && (m_shadowOpacity != 1.0)) {
+        opacity = m_shadowOpacity;
     }
 
-    auto &shadow = (window()->isActive()) ? g_sShadow : g_sShadowInactive;
+    // Animation frames are quantized, so that all decorations share a few shadow
+    // objects. Windows on outputs with different scales have different corner radii.
+    const int step = shadowLadderStep(opacity);
+    const DecorationShadowKey key{m_internalSettings->shadowSize(),
+                                  m_internalSettings->shadowColor().rgba(),
+                                  m_internalSettings->shadowStrength(),
+                                  m_scaledCornerRadius,
+                                  step};
+
+    std::shared_ptr<KDecoration3::DecorationShadow> shadow = g_shadows.value(key).lock();
     if (!shadow) {
-        g_sShadow = createShadowObject(1.0);
-        g_sShadowInactive = createShadowObject(0.5);
+        shadow = createShadowObject(0.5 + 0.5 * step / (g_shadowLadderSteps - 1));
+
+        // Drop the shadows that are not used anymore.
+        for (auto it = g_shadows.begin(); it != g_shadows.end();) {
+            if (it.value().expired()) {
+                it = g_shadows.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        if (shadow) {
+            g_shadows.insert(key, shadow);
+        }
     }
+
     setShadow(shadow);
 }
 
@@ -828,12 +1061,7 @@ std::shared_ptr<KDecoration3::DecorationShadow> Decoration::createShadowObject(c
     shadowRenderer.addShadow(params.shadow1.offset, params.shadow1.radius, withOpacity(m_internalSettings->shadowColor(), params.shadow1.opacity * strength));
     shadowRenderer.addShadow(params.shadow2.offset, params.shadow2.radius, withOpacity(m_internalSettings->shadowColor(), params.shadow2.opacity * strength));
 
-    QImage shadowTexture = shadowRenderer.render();
-
-    QPainter painter(&shadowTexture);
-    painter.setRenderHint(QPainter::Antialiasing);
-
-    const QRectF outerRect = shadowTexture.rect();
+    const QRectF outerRect(QPoint(0, 0), shadowRenderer.textureSize());
 
     QRectF boxRect(QPoint(0, 0), boxSize);
     boxRect.moveCenter(outerRect.center());
@@ -847,13 +1075,9 @@ std::shared_ptr<KDecoration3::DecorationShadow> Decoration::createShadowObject(c
     // Push the shadow slightly under the window, which helps avoiding glitches with fractional scaling
     // TODO fix this more properly
     innerRect.adjust(2, 2, -2, -2);
+    shadowRenderer.setCutout(innerRect, m_scaledCornerRadius + 0.5);
 
-    painter.setPen(Qt::NoPen);
-    painter.setBrush(Qt::black);
-    painter.setCompositionMode(QPainter::CompositionMode_DestinationOut);
-    painter.drawRoundedRect(innerRect, m_scaledCornerRadius + 0.5, m_scaledCornerRadius + 0.5);
-
-    painter.end();
+    const QImage shadowTexture = ShadowCache::self().render(shadowRenderer);
 
     auto ret = std::make_shared<KDecoration3::DecorationShadow>();
     ret->setPadding(padding);
@@ -8,15 +8,17 @@
 #pragma once
 
 #include "breeze.h"
+#include "breezeanimationclock.h"
 #include "breezesettings.h"
 
 #include <KDecoration3/DecoratedWindow>
 #include <KDecoration3/Decoration>
 #include <KDecoration3/DecorationSettings>
 
+#include <QFont>
 #include <QPalette>
+#include <QStaticText>
 #include <QVariant>
-#include <QVariantAnimation>
 
 namespace KDecoration3
 {
@@ -44,7 +46,7 @@ public:
 
     qreal animationsDuration() const
     {
-        return m_animation->duration();
+        return m_animation.duration();
     }
 
     //* caption height
@@ -62,6 +64,12 @@ public:
         return m_opacity;
     }
 
+    //* true while colors change between the inactive and the active ones
+    bool isAnimating() const
+    {
+        return m_animation.state() == QAbstractAnimation::Running;
+    }
+
     //@}
 
     //*@name colors
@@ -84,6 +92,13 @@ public:
     inline bool hideTitleBar() const;
     //@}
 
+    //* parts of the layout to recompute
+    enum LayoutFlag {
+        LayoutTitleBar = 1 << 0,
+        LayoutButtons = 1 << 1,
+    };
+    Q_DECLARE_FLAGS(LayoutFlags, LayoutFlag)
+
 public Q_SLOTS:
     bool init() override;
 
@@ -91,15 +106,29 @@ private Q_SLOTS:
     void reconfigure();
     void recalculateBorders();
     void updateButtonsGeometry();
-    void updateButtonsGeometryDelayed();
     void updateTitleBar();
     void updateAnimationState();
     void updateScale();
 
 private:
+    //* recompute the given parts of the layout once control returns to the event loop
+    void scheduleLayout(LayoutFlags flags);
+
+    //* recompute the given parts of the layout right away, along with the scheduled ones
+    void flushLayout(LayoutFlags flags);
+
+    //* recompute the parts of the layout marked dirty
+    void updateLayout();
+
     //* return the rect in which caption will be drawn
     QPair<QRectF, Qt::Alignment> captionRect() const;
 
+    //* caption shaped and elided to the given width, for the painter's font
+    const QStaticText &captionText(QPainter *painter, qreal availableWidth);
+
+    //* width of the whole caption, in the decoration font
+    qreal captionWidth() const;
+
     void createButtons();
     void paintTitleBar(QPainter *painter, const QRectF &repaintRegion);
     void updateShadow();
@@ -113,6 +142,9 @@ private:
     inline bool hasNoBorders() const;
     inline bool hasNoSideBorders() const;
     QMarginsF bordersFor(qreal scale) const;
+
+    //* height of the decoration font, kept until the font changes
+    int fontHeight() const;
     //@}
 
     inline bool outlinesEnabled() const;
@@ -122,8 +154,8 @@ private:
     KDecoration3::DecorationButtonGroup *m_rightButtons = nullptr;
 
     //* active state change animation
-    QVariantAnimation *m_animation;
-    QVariantAnimation *m_shadowAnimation;
+    ClockedAnimation m_animation;
+    ClockedAnimation m_shadowAnimation;
 
     //* active state change opacity
     qreal m_opacity = 0;
@@ -131,6 +163,24 @@ private:
 
     //*frame corner radius, scaled according to DPI
     qreal m_scaledCornerRadius = 3;
+
+    //* parts of the layout waiting to be recomputed
+    LayoutFlags m_dirtyLayout;
+
+    //* cached height of the decoration font, negative when unknown
+    mutable int m_fontHeight = -1;
+
+    //* caption laid out for painting, rebuilt only when the caption, its font, the room for it or the scale changes
+    struct CaptionLayout {
+        QString caption;
+        QFont font;
+        qreal fullWidth = 0;
+
+        qreal availableWidth = -1;
+        qreal devicePixelRatio = 0;
+        QStaticText text;
+    };
+    mutable CaptionLayout m_captionLayout;
 };
 
 bool Decoration::hasBorders() const
@@ -208,3 +258,5 @@ bool Decoration::outlinesEnabled() const
     return m_internalSettings->outlineEnabled();
 }
 }
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(Breeze::Decoration::LayoutFlags)
@@ -0,0 +1,197 @@
+/*
+ * SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#include "breezeexceptionmatcher.h"
+
+#include <limits>
+
+namespace Breeze
+{
+//* window classes remembered before the memoized matches are dropped
+static const int s_maxClassMatches = 256;
+
+//__________________________________________________________________
+static bool isLiteral(QStringView pattern)
+{
+    static const QString metaCharacters = QStringLiteral("\\^$.|?*+()[]{}");
+    for (const QChar c : pattern) {
+        if (metaCharacters.contains(c)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//__________________________________________________________________
+ExceptionMatcher::Pattern::Pattern(const QString &pattern, int index)
+    : index(index)
+{
+    QStringView body(pattern);
+    const bool anchoredStart = body.startsWith(QLatin1Char('^'));
+    if (anchoredStart) {
+        body = body.mid(1);
+    }
+
+    const bool anchoredEnd = body.endsWith(QLatin1Char('$'));
+    if (anchoredEnd) {
+        body.chop(1);
+    }
+
+    if (isLiteral(body)) {
+        text = body.toString();
+        if (anchoredStart && anchoredEnd) {
+            kind = Exact;
+        } else if (anchoredStart) {
+            kind = Prefix;
+        } else if (anchoredEnd) {
+            kind = Suffix;
+        } else {
+            kind = Contains;
+        }
+        return;
+    }
+
+    kind = RegularExpression;
+    regularExpression.setPattern(pattern);
+    regularExpression.optimize();
+}
+
+//__________________________________________________________________
+bool ExceptionMatcher::Pattern::matches(const QString &value) const
+{
+    switch (kind) {
+    case Contains:
+        return value.contains(text);
+    case Prefix:
+        return value.startsWith(text);
+    case Suffix:
+        return value.endsWith(text);
+    case Exact:
+        return value == text;
+    default:
+    case RegularExpression:
+        return regularExpression.match(value).hasMatch();
+    }
+}
+
+//__________________________________________________________________
+void ExceptionMatcher::Group::add(const Pattern &pattern)
+{
+    if (pattern.kind == Pattern::Exact) {
+        // keep the first exception for a given pattern, later ones never match
+        if (!m_exact.contains(pattern.text)) {
+            m_exact.insert(pattern.text, pattern.index);
+        }
+        return;
+    }
+
+    // invalid regular expressions never match
+    if (pattern.kind == Pattern::RegularExpression && !pattern.regularExpression.isValid()) {
+        return;
+    }
+
+    m_patterns.append(pattern);
+}
+
+//__________________________________________________________________
+int ExceptionMatcher::Group::match(const QString &value, int limit) const
+{
+    int index = limit;
+
+    const auto exact = m_exact.constFind(value);
+    if (exact != m_exact.constEnd() && exact.value() < index) {
+        index = exact.value();
+    }
+
+    // patterns are sorted, stop at the first match or when no earlier exception is left
+    for (const Pattern &pattern : m_patterns) {
+        if (pattern.index >= index) {
+            break;
+        }
+
+        if (pattern.matches(value)) {
+            index = pattern.index;
+            break;
+        }
+    }
+
+    return index < limit ? index : -1;
+}
+
+//__________________________________________________________________
+ExceptionMatcher::ExceptionMatcher(const InternalSettingsList &exceptions)
+{
+    for (const auto &internalSettings : exceptions) {
+        // discard disabled exceptions
+        if (!internalSettings->enabled()) {
+            continue;
+        }
+
+        // discard exceptions with empty exception pattern
+        if (internalSettings->exceptionPattern().isEmpty()) {
+            continue;
+        }
+
+        const Pattern pattern(internalSettings->exceptionPattern(), m_exceptions.size());
+        switch (internalSettings->exceptionType()) {
+        case InternalSettings::ExceptionWindowTitle:
+            m_titles.add(pattern);
+            break;
+
+        default:
+        case InternalSettings::ExceptionWindowClassName:
+            m_classes.add(pattern);
+            break;
+        }
+
+        m_exceptions.append(internalSettings);
+    }
+}
+
+//__________________________________________________________________
+InternalSettingsPtr ExceptionMatcher::match(const QString &windowClass, const QString &windowTitle) const
+{
+    if (m_exceptions.isEmpty()) {
+        return InternalSettingsPtr();
+    }
+
+    // window class exceptions only depend on the window class, remember them
+    int index = -1;
+    {
+        std::unique_lock<std::mutex> lock(m_classMatchesMutex, std::try_to_lock);
+        bool found = false;
+        if (lock.owns_lock()) {
+            const auto classMatch = m_classMatches.constFind(windowClass);
+            if (classMatch != m_classMatches.constEnd()) {
+                index = classMatch.value();
+                found = true;
+            }
+        }
+
+        if (!found) {
+            index = m_classes.match(windowClass, std::numeric_limits<int>::max());
+            if (lock.owns_lock()) {
+                if (m_classMatches.size() >= s_maxClassMatches) {
+                    m_classMatches.clear();
+                }
+                m_classMatches.insert(windowClass, index);
+            }
+        }
+    }
+
+    // window titles change all the time, only look for title exceptions listed before the class match
+    if (!m_titles.isEmpty()) {
+        const int titleIndex = m_titles.match(windowTitle, index < 0 ? std::numeric_limits<int>::max() : index);
+        if (titleIndex >= 0) {
+            index = titleIndex;
+        }
+    }
+
+    return index < 0 ? InternalSettingsPtr() : m_exceptions.at(index);
+}
+
+}
@@ -0,0 +1,122 @@
+/*
+ * SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+ */
+
+#pragma once
+
+#include "breeze.h"
+#include "breezesettings.h"
+
+#include <QHash>
+#include <QRegularExpression>
+#include <QString>
+#include <QVector>
+
+#include <mutex>
+
+namespace Breeze
+{
+/**
+ * Window decoration exceptions, compiled for lookup.
+ *
+ * Exceptions are compiled once when the configuration is read: patterns
+ * without regular expression syntax are compared as plain strings, whole
+ * string matches are looked up in a hash and only the remaining patterns are
+ * kept as optimized regular expressions. Lookups return the same exception as
+ * matching every pattern in order would, the first one in the list wins.
+ *
+ * The matcher does not change once built, so it can be used from any thread.
+ **/
+class ExceptionMatcher
+{
+public:
+    //* constructor
+    explicit ExceptionMatcher(const InternalSettingsList &exceptions = InternalSettingsList());
+
+    //* not copyable, matchers are shared through the settings snapshot
+    ExceptionMatcher(const ExceptionMatcher &) = delete;
+    ExceptionMatcher &operator=(const ExceptionMatcher &) = delete;
+
+    //* true if some exception matches the window title
+    bool hasTitlePatterns() const
+    {
+        return !m_titles.isEmpty();
+    }
+
+    /**
+     * first exception matching the window, or a null pointer
+     * @param windowTitle is only used if hasTitlePatterns() is true
+     **/
+    InternalSettingsPtr match(const QString &windowClass, const QString &windowTitle) const;
+
+private:
+    //* compiled exception pattern
+    class Pattern
+    {
+    public:
+        enum Kind {
+            Contains,
+            Prefix,
+            Suffix,
+            Exact,
+            RegularExpression,
+        };
+
+        //* compile pattern
+        Pattern(const QString &pattern, int index);
+
+        //* true if the pattern matches the value
+        bool matches(const QString &value) const;
+
+        Kind kind = RegularExpression;
+        QString text;
+        QRegularExpression regularExpression;
+
+        //* position of the exception in the list
+        int index = 0;
+    };
+
+    //* patterns compared against the same window property
+    class Group
+    {
+    public:
+        //* add pattern
+        void add(const Pattern &pattern);
+
+        //* true if empty
+        bool isEmpty() const
+        {
+            return m_exact.isEmpty() && m_patterns.isEmpty();
+        }
+
+        //* index of the first matching exception before limit, or -1
+        int match(const QString &value, int limit) const;
+
+    private:
+        //* first exception for every exact pattern
+        QHash<QString, int> m_exact;
+
+        //* other patterns, in list order
+        QVector<Pattern> m_patterns;
+    };
+
+    //* enabled exceptions, in list order
+    InternalSettingsList m_exceptions;
+
+    //*@name patterns by exception type
+    //@{
+    Group m_classes;
+    Group m_titles;
+    //@}
+
+    /**
+     * first window class exception matching a given window class, or -1
+     * lookups may run on any thread, the memo is skipped rather than waited for when busy
+     **/
+    mutable QHash<QString, int> m_classMatches;
+    mutable std::mutex m_classMatchesMutex;
+};
+
+}
@@ -7,96 +7,106 @@
 #include "breezesettingsprovider.h"
 
 #include "breezeexceptionlist.h"
+#include "breezeshadowcache.h"
 
-#include <QRegularExpression>
+#include <KConfigGroup>
+
+#include <QDBusConnection>
 #include <QTextStream>
 
 namespace Breeze
 {
-SettingsProvider *SettingsProvider::s_self = nullptr;
-
 //__________________________________________________________________
 SettingsProvider::SettingsProvider()
     : m_config(KSharedConfig::openConfig(QStringLiteral("breezerc")))
 {
+    m_reconfigureTimer.setSingleShot(true);
+    m_reconfigureTimer.setInterval(0);
+    connect(&m_reconfigureTimer, &QTimer::timeout, this, [this]() {
+        reconfigure();
+        Q_EMIT reconfigured();
+    });
+
+    // use DBus connection to update on breeze configuration change, once for all decorations
+    auto dbus = QDBusConnection::sessionBus();
+    dbus.connect(QString(),
+                 QStringLiteral("/KGlobalSettings"),
+                 QStringLiteral("org.kde.KGlobalSettings"),
+                 QStringLiteral("notifyChange"),
+                 this,
+                 SLOT(scheduleReconfigure()));
+
     reconfigure();
 }
 
 //__________________________________________________________________
-SettingsProvider::~SettingsProvider()
-{
-    s_self = nullptr;
-}
+SettingsProvider::~SettingsProvider() = default;
 
 //__________________________________________________________________
 SettingsProvider *SettingsProvider::self()
 {
-    // TODO: this is not thread safe!
-    if (!s_self) {
-        s_self = new SettingsProvider();
-    }
+    // initialization of function local statics is thread safe
+    static SettingsProvider *provider = new SettingsProvider();
+    return provider;
+}
 
-    return s_self;
+//__________________________________________________________________
+std::shared_ptr<const SettingsProvider::Snapshot> SettingsProvider::snapshot() const
+{
+#if defined(__cpp_lib_atomic_shared_ptr)
+    return m_snapshot.load(std::memory_order_acquire);
+#else
+    std::lock_guard<std::mutex> lock(m_snapshotMutex);
+    return m_snapshot;
+#endif
 }
 
 //__________________________________________________________________
 void SettingsProvider::reconfigure()
 {
-    if (!m_defaultSettings) {
-        m_defaultSettings = InternalSettingsPtr(new InternalSettings());
-        m_defaultSettings->setCurrentGroup(QStringLiteral("Windeco"));
-    }
+    // settings in use by decorations are never modified, load new ones
+    InternalSettingsPtr defaultSettings(new InternalSettings());
+    defaultSettings->setCurrentGroup(QStringLiteral("Windeco"));
+    defaultSettings->load();
 
-    m_defaultSettings->load();
+    // shadows are shared by all decorations, and so is their budget
+    ShadowCache::self().setMaxBytes(qint64(defaultSettings->shadowCacheSize()) * 1024 * 1024);
 
     ExceptionList exceptions;
     exceptions.readConfig(m_config);
-    m_exceptions = exceptions.get();
+
+    // animation
+    KSharedConfig::Ptr config = KSharedConfig::openConfig();
+    const KConfigGroup cg(config, QStringLiteral("KDE"));
+
+    auto snapshot = std::shared_ptr<Snapshot>(new Snapshot{defaultSettings, ExceptionMatcher(exceptions.get()), cg.readEntry("AnimationDurationFactor", 1.0f)});
+
+#if defined(__cpp_lib_atomic_shared_ptr)
+    m_snapshot.store(std::move(snapshot), std::memory_order_release);
+#else
+    // the previous snapshot is released after unlocking, its destruction may take a while
+    std::shared_ptr<const Snapshot> previous(std::move(snapshot));
+    {
+        std::lock_guard<std::mutex> lock(m_snapshotMutex);
+        m_snapshot.swap(previous);
+    }
+#endif
 }
 
 //__________________________________________________________________
-InternalSettingsPtr SettingsProvider::internalSettings(Decoration *decoration) const
+void SettingsProvider::scheduleReconfigure()
 {
-    QString windowTitle;
-    QString windowClass;
-
-    for (auto internalSettings : std::as_const(m_exceptions)) {
-        // discard disabled exceptions
-        if (!internalSettings->enabled()) {
-            continue;
-        }
-
-        // discard exceptions with empty exception pattern
-        if (internalSettings->exceptionPattern().isEmpty()) {
-            continue;
-        }
-
-        /*
-        decide which value is to be compared
-        to the regular expression, based on exception type
-        */
-        QString value;
-        switch (internalSettings->exceptionType()) {
-        case InternalSettings::ExceptionWindowTitle: {
-            value = windowTitle.isEmpty() ? (windowTitle = decoration->window()->caption()) : windowTitle;
-            break;
-        }
-
-        default:
-        case InternalSettings::ExceptionWindowClassName: {
-            value = windowClass.isEmpty() ? (windowClass = decoration->window()->windowClass()) : windowClass;
-            break;
-        }
-        }
-
-        // check matching
-        QRegularExpression rx(internalSettings->exceptionPattern());
-        if (rx.match(value).hasMatch()) {
-            return internalSettings;
-        }
-    }
+    m_reconfigureTimer.start();
+}
 
-    return m_defaultSettings;
+//__________________________________________________________________
+InternalSettingsPtr SettingsProvider::internalSettings(Decoration *decoration) const
+{
+    const auto snapshot = this->snapshot();
+    const auto window = decoration->window();
+    const InternalSettingsPtr internalSettings =
+        snapshot->exceptions.match(window->windowClass(), snapshot->exceptions.hasTitlePatterns() ? window->caption() : QString());
+    return internalSettings ? internalSettings : snapshot->defaultSettings;
 }
 
 }
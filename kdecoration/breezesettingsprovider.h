@@ -8,11 +8,17 @@
 
 #include "breeze.h"
 #include "breezedecoration.h"
+#include "breezeexceptionmatcher.h"
 #include "breezesettings.h"
 
 #include <KSharedConfig>
 
 #include <QObject>
+#include <QTimer>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
 
 namespace Breeze
 {
@@ -24,32 +30,70 @@ public:
     //* destructor
     ~SettingsProvider();
 
-    //* singleton
+    //* singleton, first created from the main thread by the decorations
     static SettingsProvider *self();
 
+    /**
+     * Configuration read at the last reconfigure.
+     *
+     * A snapshot never changes, reconfigure publishes a new one instead. It is
+     * safe to read snapshots from any thread. Getting the current one is lock
+     * free where std::atomic<std::shared_ptr> is available, otherwise a mutex is
+     * held just long enough to copy the pointer.
+     **/
+    struct Snapshot {
+        //* default configuration
+        InternalSettingsPtr defaultSettings;
+
+        //* exceptions, compiled at reconfigure
+        ExceptionMatcher exceptions;
+
+        //* global animation duration factor
+        qreal animationDurationFactor = 1.0;
+    };
+
+    //* current configuration
+    std::shared_ptr<const Snapshot> snapshot() const;
+
     //* internal settings for given decoration
     InternalSettingsPtr internalSettings(Decoration *) const;
 
+    //* global animation duration factor
+    qreal animationDurationFactor() const
+    {
+        return snapshot()->animationDurationFactor;
+    }
+
+Q_SIGNALS:
+
+    //* emitted once the configuration has been read again, decorations should reconfigure
+    void reconfigured();
+
 public Q_SLOTS:
 
     //* reconfigure
     void reconfigure();
 
+    //* reconfigure once control returns to the event loop, merging all requests until then
+    void scheduleReconfigure();
+
 private:
     //* constructor
     SettingsProvider();
 
-    //* default configuration
-    InternalSettingsPtr m_defaultSettings;
-
-    //* exceptions
-    InternalSettingsList m_exceptions;
+    //* current configuration
+#if defined(__cpp_lib_atomic_shared_ptr)
+    std::atomic<std::shared_ptr<const Snapshot>> m_snapshot;
+#else
+    std::shared_ptr<const Snapshot> m_snapshot;
+    mutable std::mutex m_snapshotMutex;
+#endif
 
     //* config object
     KSharedConfigPtr m_config;
 
-    //* singleton
-    static SettingsProvider *s_self;
+    //* delayed reconfiguration
+    QTimer m_reconfigureTimer;
 };
 
 }
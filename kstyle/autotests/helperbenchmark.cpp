@@ -0,0 +1,235 @@
+/*
+ * SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "breezeanimationdata.h"
+#include "breezehelper.h"
+
+#include <QHash>
+#include <QPainter>
+#include <QStandardPaths>
+#include <QTest>
+
+using namespace Breeze;
+
+Q_DECLARE_METATYPE(Breeze::StateProperties)
+Q_DECLARE_METATYPE(Breeze::Corners)
+
+/**
+ * Measure the button frame and tab rendering of the helper, as the style calls
+ * them on every paint. Each case runs with the primitive cache warm, as it is once
+ * an application has painted its first frame, and with the cache disabled, which
+ * renders every frame from scratch as before the cache existed.
+ *
+ * The cost of describing the widget state is measured separately, with the flags
+ * passed today and with the QHash<QByteArray, bool> the style used to build.
+ **/
+class HelperBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void renderButtonFrame_data();
+    void renderButtonFrame();
+
+    void renderTabBarTab_data();
+    void renderTabBarTab();
+
+    void buttonState_data();
+    void buttonState();
+
+private:
+    Helper *m_helper = nullptr;
+};
+
+//* default PrimitiveCacheSize of the style configuration, in bytes
+static const qint64 s_primitiveCacheBytes = 8192 * 1024;
+
+//* row name suffix for the primitive cache being enabled or not
+static const char *cacheSuffix(bool cached)
+{
+    return cached ? "cached" : "uncached";
+}
+
+//________________________________________________________________
+void HelperBenchmark::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+
+    m_helper = new Helper(KSharedConfig::openConfig());
+    m_helper->loadConfig();
+}
+
+//________________________________________________________________
+void HelperBenchmark::cleanupTestCase()
+{
+    delete m_helper;
+    m_helper = nullptr;
+}
+
+//________________________________________________________________
+void HelperBenchmark::renderButtonFrame_data()
+{
+    QTest::addColumn<bool>("cached");
+    QTest::addColumn<StateProperties>("stateProperties");
+    QTest::addColumn<qreal>("animation");
+
+    const qreal invalid = AnimationData::OpacityInvalid;
+    const StateProperties normal = StateEnabled | StateActiveWindow;
+
+    for (const bool cached : {true, false}) {
+        const char *suffix = cacheSuffix(cached);
+        QTest::addRow("normal, %s", suffix) << cached << normal << invalid;
+        QTest::addRow("hovered, %s", suffix) << cached << (normal | StateHovered) << invalid;
+        QTest::addRow("hovered, animated, %s", suffix) << cached << (normal | StateHovered) << qreal(0.5);
+        QTest::addRow("down, %s", suffix) << cached << (normal | StateHovered | StateDown) << invalid;
+        QTest::addRow("checked, %s", suffix) << cached << (normal | StateChecked) << invalid;
+        QTest::addRow("default, focused, %s", suffix) << cached << (normal | StateDefaultButton | StateVisualFocus) << invalid;
+        QTest::addRow("flat, %s", suffix) << cached << (normal | StateFlat) << invalid;
+        QTest::addRow("flat, hovered, %s", suffix) << cached << (normal | StateFlat | StateHovered) << invalid;
+        QTest::addRow("round, %s", suffix) << cached << (normal | StateRoundButton) << invalid;
+        QTest::addRow("disabled, %s", suffix) << cached << StateProperties(StateActiveWindow) << invalid;
+    }
+}
+
+//________________________________________________________________
+void HelperBenchmark::renderButtonFrame()
+{
+    QFETCH(bool, cached);
+    QFETCH(StateProperties, stateProperties);
+    QFETCH(qreal, animation);
+
+    m_helper->setPrimitiveCacheMaxBytes(cached ? s_primitiveCacheBytes : 0);
+
+    QImage image(QSize(120, 32), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    const QRectF rect(image.rect());
+    const QPalette palette;
+
+    QBENCHMARK {
+        painter.save();
+        m_helper->renderButtonFrame(&painter, rect, palette, stateProperties, animation, animation);
+        painter.restore();
+    }
+}
+
+//________________________________________________________________
+void HelperBenchmark::renderTabBarTab_data()
+{
+    QTest::addColumn<bool>("cached");
+    QTest::addColumn<StateProperties>("stateProperties");
+    QTest::addColumn<Corners>("corners");
+    QTest::addColumn<qreal>("animation");
+
+    const qreal invalid = AnimationData::OpacityInvalid;
+    const StateProperties north = StateEnabled | StateDocumentMode | StateNorth;
+    const StateProperties west = StateEnabled | StateDocumentMode | StateWest;
+
+    for (const bool cached : {true, false}) {
+        const char *suffix = cacheSuffix(cached);
+        QTest::addRow("north, %s", suffix) << cached << north << Corners(CornersTop) << invalid;
+        QTest::addRow("north, hovered, %s", suffix) << cached << (north | StateHovered) << Corners(CornersTop) << invalid;
+        QTest::addRow("north, hovered, animated, %s", suffix) << cached << (north | StateHovered) << Corners(CornersTop) << qreal(0.5);
+        QTest::addRow("north, selected, %s", suffix) << cached << (north | StateSelected) << Corners(CornersTop) << invalid;
+        QTest::addRow("west, %s", suffix) << cached << west << Corners(CornersLeft) << invalid;
+        QTest::addRow("west, selected, %s", suffix) << cached << (west | StateSelected) << Corners(CornersLeft) << invalid;
+    }
+}
+
+//________________________________________________________________
+void HelperBenchmark::renderTabBarTab()
+{
+    QFETCH(bool, cached);
+    QFETCH(StateProperties, stateProperties);
+    QFETCH(Corners, corners);
+    QFETCH(qreal, animation);
+
+    m_helper->setPrimitiveCacheMaxBytes(cached ? s_primitiveCacheBytes : 0);
+
+    QImage image(QSize(160, 32), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    const QRectF rect(image.rect());
+    const QPalette palette;
+
+    QBENCHMARK {
+        painter.save();
+        m_helper->renderTabBarTab(&painter, rect, palette, stateProperties, corners, animation);
+        painter.restore();
+    }
+}
+
+//________________________________________________________________
+void HelperBenchmark::buttonState_data()
+{
+    QTest::addColumn<bool>("flags");
+
+    QTest::newRow("flags") << true;
+    QTest::newRow("hash") << false;
+}
+
+//________________________________________________________________
+void HelperBenchmark::buttonState()
+{
+    QFETCH(bool, flags);
+
+    // describe a push button the way drawPanelButtonCommandPrimitive does, then read it back as renderButtonFrame does
+    volatile bool hovered = true;
+    int count = 0;
+
+    if (flags) {
+        QBENCHMARK {
+            StateProperties stateProperties;
+            stateProperties.setFlag(StateEnabled, true);
+            stateProperties.setFlag(StateVisualFocus, false);
+            stateProperties.setFlag(StateHovered, hovered);
+            stateProperties.setFlag(StateDown, false);
+            stateProperties.setFlag(StateChecked, false);
+            stateProperties.setFlag(StateFlat, false);
+            stateProperties.setFlag(StateHasMenu, false);
+            stateProperties.setFlag(StateDefaultButton, false);
+            stateProperties.setFlag(StateNeutralHighlight, false);
+            stateProperties.setFlag(StateActiveWindow, true);
+            stateProperties.setFlag(StateRoundButton, false);
+
+            count += stateProperties.testFlag(StateEnabled) + stateProperties.testFlag(StateVisualFocus) + stateProperties.testFlag(StateHovered)
+                + stateProperties.testFlag(StateDown) + stateProperties.testFlag(StateChecked) + stateProperties.testFlag(StateFlat)
+                + stateProperties.testFlag(StateDefaultButton) + stateProperties.testFlag(StateNeutralHighlight)
+                + stateProperties.testFlag(StateActiveWindow) + stateProperties.testFlag(StateRoundButton);
+        }
+    } else {
+        QBENCHMARK {
+            QHash<QByteArray, bool> stateProperties;
+            stateProperties["enabled"] = true;
+            stateProperties["visualFocus"] = false;
+            stateProperties["hovered"] = hovered;
+            stateProperties["down"] = false;
+            stateProperties["checked"] = false;
+            stateProperties["flat"] = false;
+            stateProperties["hasMenu"] = false;
+            stateProperties["defaultButton"] = false;
+            stateProperties["hasNeutralHighlight"] = false;
+            stateProperties["isActiveWindow"] = true;
+            stateProperties["roundButton"] = false;
+
+            count += stateProperties.value("enabled", true) + stateProperties.value("visualFocus") + stateProperties.value("hovered")
+                + stateProperties.value("down") + stateProperties.value("checked") + stateProperties.value("flat")
+                + stateProperties.value("defaultButton") + stateProperties.value("hasNeutralHighlight")
+                + stateProperties.value("isActiveWindow") + stateProperties.value("roundButton");
+        }
+    }
+
+    QVERIFY(count > 0);
+}
+
+QTEST_MAIN(HelperBenchmark)
+
+#include "helperbenchmark.moc"
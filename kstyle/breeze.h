@@ -63,6 +63,35 @@ enum Side {
 
 Q_DECLARE_FLAGS(Sides, Side)
 
+//* widget state, passed to the button frame and tab rendering methods of the helper
+enum StateProperty {
+    StateNone = 0,
+    StateEnabled = 0x1,
+    StateVisualFocus = 0x2,
+    StateHovered = 0x4,
+    StateDown = 0x8,
+    StateChecked = 0x10,
+    StateSelected = 0x20,
+    StateFlat = 0x40,
+    StateHasMenu = 0x80,
+    StateDefaultButton = 0x100,
+    StateNeutralHighlight = 0x200,
+    StateActiveWindow = 0x400,
+    StateRoundButton = 0x800,
+    StateDocumentMode = 0x1000,
+    StateNorth = 0x2000,
+    StateSouth = 0x4000,
+    StateWest = 0x8000,
+    StateEast = 0x10000,
+    StateFirst = 0x20000,
+    StateLast = 0x40000,
+    StateRightOfSelected = 0x80000,
+    StateQtQuickControl = 0x100000,
+    StateAlteredBackground = 0x200000,
+};
+
+Q_DECLARE_FLAGS(StateProperties, StateProperty)
+
 //* checkbox state
 enum CheckBoxState {
     CheckOff,
@@ -100,3 +129,4 @@ enum ButtonType {
 Q_DECLARE_OPERATORS_FOR_FLAGS(Breeze::AnimationModes)
 Q_DECLARE_OPERATORS_FOR_FLAGS(Breeze::Corners)
 Q_DECLARE_OPERATORS_FOR_FLAGS(Breeze::Sides)
+Q_DECLARE_OPERATORS_FOR_FLAGS(Breeze::StateProperties)
@@ -30,7 +30,11 @@
 #include <QWindow>
 
 #include <QDialog>
+#include <QPaintEngine>
+
 #include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace Breeze
 {
@@ -41,6 +45,31 @@ static const qreal highlightBackgroundAlpha = Metrics::Blend_Value;
 
 static const auto radioCheckSunkenDarkeningFactor = 110;
 
+//* default budget of the rendered primitive cache, in kilobytes
+static const int defaultPrimitiveCacheSize = 8 * 1024;
+
+//* palettes whose derived colors are kept, widgets only use a few at once
+static const int derivedColorsCacheSize = 8;
+
+//* cost of a cached pixmap, in kilobytes
+static int primitiveCost(const QPixmap &pixmap)
+{
+    return std::max<qint64>(1, qint64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8 / 1024);
+}
+
+//* transparent pixmap covering rect, with the primitive painted in it
+template<typename Paint>
+static QPixmap renderPrimitive(const QRect &rect, const QRectF &primitiveRect, qreal devicePixelRatio, Paint paint)
+{
+    QPixmap pixmap(rect.size() * devicePixelRatio);
+    pixmap.setDevicePixelRatio(devicePixelRatio);
+    pixmap.fill(Qt::transparent);
+
+    QPainter painter(&pixmap);
+    paint(&painter, primitiveRect.translated(-rect.topLeft()));
+    return pixmap;
+}
+
 PaletteChangedEventFilter::PaletteChangedEventFilter(Helper *helper)
     : QObject(helper)
     , _helper(helper)
@@ -75,6 +104,8 @@ Helper::Helper(KSharedConfig::Ptr config)
     , _kwinConfig(KSharedConfig::openConfig("kwinrc"))
     , _eventFilter(new PaletteChangedEventFilter(this))
 {
+    _primitiveCache.setMaxCost(defaultPrimitiveCacheSize);
+    _derivedColors.setMaxCost(derivedColorsCacheSize);
 }
 
 //____________________________________________________________________
@@ -95,6 +126,8 @@ void Helper::loadConfig()
     _config->reparseConfiguration();
     _kwinConfig->reparseConfiguration();
     _cachedAutoValid = false;
+    _primitiveCache.clear();
+    _derivedColors.clear();
 
     KConfigGroup globalGroup(_config->group(QStringLiteral("WM")));
     _activeTitleBarColor = globalGroup.readEntry("activeBackground", palette.color(QPalette::Active, QPalette::Highlight));
@@ -117,6 +150,93 @@ void Helper::loadConfig()
     }
 }
 
+//____________________________________________________________________
+void Helper::setPrimitiveCacheMaxBytes(qint64 bytes)
+{
+    _primitiveCache.setMaxCost(int(qBound<qint64>(0, bytes / 1024, std::numeric_limits<int>::max())));
+}
+
+//____________________________________________________________________
+bool Helper::canUsePrimitiveCache(QPainter *painter) const
+{
+    if (_primitiveCache.maxCost() <= 0) {
+        return false;
+    }
+
+    // blitting gives the same pixels as painting only for raster devices, plain alpha blending,
+    // and translations by whole device pixels
+    if (!painter->paintEngine() || painter->paintEngine()->type() != QPaintEngine::Raster) {
+        return false;
+    }
+
+    if (painter->opacity() != 1 || painter->compositionMode() != QPainter::CompositionMode_SourceOver) {
+        return false;
+    }
+
+    const qreal devicePixelRatio = this->devicePixelRatio(painter);
+    if (devicePixelRatio != std::round(devicePixelRatio)) {
+        return false;
+    }
+
+    const QTransform &transform = painter->worldTransform();
+    return transform.type() <= QTransform::TxTranslate && transform.dx() == std::round(transform.dx()) && transform.dy() == std::round(transform.dy());
+}
+
+//____________________________________________________________________
+template<typename Paint>
+bool Helper::renderCachedPixmap(QPainter *painter, const QRectF &rect, PrimitiveKey key, Paint paint) const
+{
+    if (!canUsePrimitiveCache(painter)) {
+        return false;
+    }
+
+    const QRect alignedRect = rect.toAlignedRect();
+    key.size = rect.size();
+    key.offset = rect.topLeft() - alignedRect.topLeft();
+    key.devicePixelRatio = devicePixelRatio(painter);
+
+    QPixmap pixmap;
+    if (const auto cached = _primitiveCache.object(key)) {
+        pixmap = cached->pixmap;
+    } else {
+        pixmap = renderPrimitive(alignedRect, rect, key.devicePixelRatio, paint);
+        _primitiveCache.insert(key, new CachedPrimitive{pixmap, TileSet()}, primitiveCost(pixmap));
+    }
+
+    painter->drawPixmap(alignedRect.topLeft(), pixmap);
+    return true;
+}
+
+//____________________________________________________________________
+template<typename Paint>
+bool Helper::renderCachedTileSet(QPainter *painter, const QRectF &rect, PrimitiveKey key, int cornerSize, Paint paint) const
+{
+    // tiles are drawn on whole pixels, and are never shrunk
+    const QRect frameRect = rect.toRect();
+    const int minSize = 2 * cornerSize + 1;
+    if (QRectF(frameRect) != rect || frameRect.width() < minSize || frameRect.height() < minSize || !canUsePrimitiveCache(painter)) {
+        return false;
+    }
+
+    // the frame is rendered once at its smallest size, with single pixel sides stretched over the rect
+    key.size = QSizeF(minSize, minSize);
+    key.devicePixelRatio = devicePixelRatio(painter);
+
+    TileSet tileSet;
+    if (const auto cached = _primitiveCache.object(key)) {
+        tileSet = cached->tileSet;
+    } else {
+        const QRect tileRect(0, 0, minSize, minSize);
+        const QPixmap pixmap = renderPrimitive(tileRect, tileRect, key.devicePixelRatio, paint);
+        tileSet = TileSet(pixmap, cornerSize, cornerSize, 1, 1);
+        _primitiveCache.insert(key, new CachedPrimitive{QPixmap(), tileSet}, primitiveCost(pixmap));
+    }
+
+    tileSet.render(frameRect, painter, TileSet::Full);
+    return true;
+}
+
+//____________________________________________________________________
 void Helper::installEventFilter(QApplication *app) const
 {
     if (app) {
@@ -138,31 +258,49 @@ QColor transparentize(const QColor &color, qreal amount)
     return clone;
 }
 
+//____________________________________________________________________
+Helper::DerivedColors Helper::derivedColors(const QPalette &palette) const
+{
+    // palettes share a cache key until modified, the current color group is not part of it
+    const QPair<qint64, int> key(palette.cacheKey(), palette.currentColorGroup());
+    if (const auto colors = _derivedColors.object(key)) {
+        return *colors;
+    }
+
+    DerivedColors colors;
+    colors.hover = _viewHoverBrush.brush(palette).color();
+    colors.focus = _viewFocusBrush.brush(palette).color();
+    colors.frameOutline = KColorUtils::mix(palette.color(QPalette::Window), palette.color(QPalette::WindowText), frameIntensityBias());
+    colors.buttonOutline = KColorUtils::mix(palette.color(QPalette::Button), palette.color(QPalette::ButtonText), frameIntensityBias());
+    colors.checkBoxIndicator = KColorUtils::mix(palette.color(QPalette::Window), palette.color(QPalette::WindowText), 0.6);
+
+    // the cache owns its copy and may evict it on any later insertion
+    _derivedColors.insert(key, new DerivedColors(colors));
+    return colors;
+}
+
 //____________________________________________________________________
 QColor Helper::frameOutlineColor(const QPalette &palette, bool mouseOver, bool hasFocus, qreal opacity, AnimationMode mode) const
 {
-    QColor outline(KColorUtils::mix(palette.color(QPalette::Window), palette.color(QPalette::WindowText), frameIntensityBias()));
+    const DerivedColors colors(derivedColors(palette));
+    QColor outline(colors.frameOutline);
 
     // focus takes precedence over hover
     if (mode == AnimationFocus) {
-        const QColor focus(focusColor(palette));
-        const QColor hover(hoverColor(palette));
-
         if (mouseOver) {
-            outline = KColorUtils::mix(hover, focus, opacity);
+            outline = KColorUtils::mix(colors.hover, colors.focus, opacity);
         } else {
-            outline = KColorUtils::mix(outline, focus, opacity);
+            outline = KColorUtils::mix(outline, colors.focus, opacity);
         }
 
     } else if (hasFocus) {
-        outline = focusColor(palette);
+        outline = colors.focus;
 
     } else if (mode == AnimationHover) {
-        const QColor hover(hoverColor(palette));
-        outline = KColorUtils::mix(outline, hover, opacity);
+        outline = KColorUtils::mix(outline, colors.hover, opacity);
 
     } else if (mouseOver) {
-        outline = hoverColor(palette);
+        outline = colors.hover;
     }
 
     return outline;
@@ -247,27 +385,25 @@ QColor Helper::arrowColor(const QPalette &palette, bool mouseOver, bool hasFocus
 //____________________________________________________________________
 QColor Helper::sliderOutlineColor(const QPalette &palette, bool mouseOver, bool hasFocus, qreal opacity, AnimationMode mode) const
 {
-    QColor outline(KColorUtils::mix(palette.color(QPalette::Button), palette.color(QPalette::ButtonText), frameIntensityBias()));
+    const DerivedColors colors(derivedColors(palette));
+    QColor outline(colors.buttonOutline);
 
     // hover takes precedence over focus
     if (mode == AnimationHover) {
-        const QColor hover(hoverColor(palette));
-        const QColor focus(focusColor(palette));
         if (hasFocus) {
-            outline = KColorUtils::mix(focus, hover, opacity);
+            outline = KColorUtils::mix(colors.focus, colors.hover, opacity);
         } else {
-            outline = KColorUtils::mix(outline, hover, opacity);
+            outline = KColorUtils::mix(outline, colors.hover, opacity);
         }
 
     } else if (mouseOver) {
-        outline = hoverColor(palette);
+        outline = colors.hover;
 
     } else if (mode == AnimationFocus) {
-        const QColor focus(focusColor(palette));
-        outline = KColorUtils::mix(outline, focus, opacity);
+        outline = KColorUtils::mix(outline, colors.focus, opacity);
 
     } else if (hasFocus) {
-        outline = focusColor(palette);
+        outline = colors.focus;
     }
 
     return outline;
@@ -305,21 +441,20 @@ QColor Helper::scrollBarHandleColor(const QPalette &palette, bool mouseOver, boo
 //______________________________________________________________________________
 QColor Helper::checkBoxIndicatorColor(const QPalette &palette, bool mouseOver, bool active, qreal opacity, AnimationMode mode) const
 {
-    QColor color(KColorUtils::mix(palette.color(QPalette::Window), palette.color(QPalette::WindowText), 0.6));
+    const DerivedColors colors(derivedColors(palette));
+    QColor color(colors.checkBoxIndicator);
     if (mode == AnimationHover) {
-        const QColor focus(focusColor(palette));
-        const QColor hover(hoverColor(palette));
         if (active) {
-            color = KColorUtils::mix(focus, hover, opacity);
+            color = KColorUtils::mix(colors.focus, colors.hover, opacity);
         } else {
-            color = KColorUtils::mix(color, hover, opacity);
+            color = KColorUtils::mix(color, colors.hover, opacity);
         }
 
     } else if (mouseOver) {
-        color = hoverColor(palette);
+        color = colors.hover;
 
     } else if (active) {
-        color = focusColor(palette);
+        color = colors.focus;
     }
 
     return color;
@@ -328,7 +463,7 @@ QColor Helper::checkBoxIndicatorColor(const QPalette &palette, bool mouseOver, b
 //______________________________________________________________________________
 QColor Helper::separatorColor(const QPalette &palette) const
 {
-    return KColorUtils::mix(palette.color(QPalette::Window), palette.color(QPalette::WindowText), frameIntensityBias());
+    return derivedColors(palette).frameOutline;
 }
 
 //______________________________________________________________________________
@@ -647,30 +782,29 @@ QRegion Helper::menuFrameRegion(const QMenu *widget)
 void Helper::renderButtonFrame(QPainter *painter,
                                const QRectF &rect,
                                const QPalette &palette,
-                               const QHash<QByteArray, bool> &stateProperties,
+                               StateProperties stateProperties,
                                qreal bgAnimation,
                                qreal penAnimation) const
 {
-    bool enabled = stateProperties.value("enabled", true);
-    bool visualFocus = stateProperties.value("visualFocus");
-    bool hovered = stateProperties.value("hovered");
-    bool down = stateProperties.value("down");
-    bool checked = stateProperties.value("checked");
-    bool flat = stateProperties.value("flat");
-    bool defaultButton = stateProperties.value("defaultButton");
-    bool hasNeutralHighlight = stateProperties.value("hasNeutralHighlight");
-    bool isActiveWindow = stateProperties.value("isActiveWindow");
-    const bool roundButton = stateProperties.value("roundButton");
+    bool enabled = stateProperties.testFlag(StateEnabled);
+    bool visualFocus = stateProperties.testFlag(StateVisualFocus);
+    bool hovered = stateProperties.testFlag(StateHovered);
+    bool down = stateProperties.testFlag(StateDown);
+    bool checked = stateProperties.testFlag(StateChecked);
+    bool flat = stateProperties.testFlag(StateFlat);
+    bool defaultButton = stateProperties.testFlag(StateDefaultButton);
+    bool hasNeutralHighlight = stateProperties.testFlag(StateNeutralHighlight);
+    bool isActiveWindow = stateProperties.testFlag(StateActiveWindow);
+    const bool roundButton = stateProperties.testFlag(StateRoundButton);
 
     // don't render background if flat and not hovered, down, checked, or given visual focus
     if (flat && !(hovered || down || checked || visualFocus) && bgAnimation == AnimationData::OpacityInvalid && penAnimation == AnimationData::OpacityInvalid) {
         return;
     }
 
-    QRectF shadowedRect = this->shadowedRect(rect);
-    QRectF frameRect = strokedRect(shadowedRect);
     // setting color group to work around KColorScheme feature
     const QColor &highlightColor = palette.color(!enabled ? QPalette::Disabled : QPalette::Active, QPalette::Highlight);
+    const QColor buttonOutline(derivedColors(palette).buttonOutline);
     QBrush bgBrush;
     QBrush penBrush;
 
@@ -680,11 +814,10 @@ void Helper::renderButtonFrame(QPainter *painter,
             bgBrush = alphaColor(highlightColor, highlightBackgroundAlpha);
         } else if (checked) {
             bgBrush = hasNeutralHighlight ? alphaColor(neutralText(palette), highlightBackgroundAlpha) : alphaColor(palette.buttonText().color(), 0.125);
-            penBrush =
-                hasNeutralHighlight ? neutralText(palette) : KColorUtils::mix(palette.button().color(), palette.buttonText().color(), frameIntensityBias());
+            penBrush = hasNeutralHighlight ? neutralText(palette) : buttonOutline;
         } else if (isActiveWindow && defaultButton) {
             bgBrush = alphaColor(highlightColor, 0.125);
-            penBrush = KColorUtils::mix(highlightColor, KColorUtils::mix(palette.button().color(), palette.buttonText().color(), frameIntensityBias()), 0.5);
+            penBrush = KColorUtils::mix(highlightColor, buttonOutline, 0.5);
         } else {
             bgBrush = alphaColor(highlightColor, 0);
             penBrush = hasNeutralHighlight ? neutralText(palette) : bgBrush;
@@ -695,15 +828,13 @@ void Helper::renderButtonFrame(QPainter *painter,
         } else if (checked) {
             bgBrush = hasNeutralHighlight ? KColorUtils::mix(palette.button().color(), neutralText(palette), Metrics::Blend_Value)
                                           : KColorUtils::mix(palette.button().color(), palette.buttonText().color(), 0.125);
-            penBrush =
-                hasNeutralHighlight ? neutralText(palette) : KColorUtils::mix(palette.button().color(), palette.buttonText().color(), frameIntensityBias());
+            penBrush = hasNeutralHighlight ? neutralText(palette) : buttonOutline;
         } else if (isActiveWindow && defaultButton) {
             bgBrush = KColorUtils::mix(palette.button().color(), highlightColor, 0.2);
-            penBrush = KColorUtils::mix(highlightColor, KColorUtils::mix(palette.button().color(), palette.buttonText().color(), frameIntensityBias()), 0.5);
+            penBrush = KColorUtils::mix(highlightColor, buttonOutline, 0.5);
         } else {
             bgBrush = palette.button().color();
-            penBrush =
-                hasNeutralHighlight ? neutralText(palette) : KColorUtils::mix(palette.button().color(), palette.buttonText().color(), frameIntensityBias());
+            penBrush = hasNeutralHighlight ? neutralText(palette) : buttonOutline;
         }
     }
 
@@ -724,19 +855,39 @@ void Helper::renderButtonFrame(QPainter *painter,
         penBrush = KColorUtils::mix(color1, color2, penAnimation);
     }
 
-    const qreal roundRadius = std::max(rect.width(), rect.height()) / 2;
-    // Shadow
-    if (isActiveWindow && !(flat || down || checked) && enabled) {
-        const qreal shadowRadius = roundButton ? roundRadius : Metrics::Frame_FrameRadius - PenWidth::Shadow / 2;
-        renderRoundedRectShadow(painter, shadowedRect, shadowColor(palette), shadowRadius);
+    const QColor shadow = isActiveWindow && !(flat || down || checked) && enabled ? shadowColor(palette) : QColor();
+    const auto paint = [&](QPainter *painter, const QRectF &rect) {
+        QRectF shadowedRect = this->shadowedRect(rect);
+        QRectF frameRect = strokedRect(shadowedRect);
+
+        const qreal roundRadius = std::max(rect.width(), rect.height()) / 2;
+        // Shadow
+        if (shadow.isValid()) {
+            const qreal shadowRadius = roundButton ? roundRadius : Metrics::Frame_FrameRadius - PenWidth::Shadow / 2;
+            renderRoundedRectShadow(painter, shadowedRect, shadow, shadowRadius);
+        }
+
+        // Render button
+        painter->setRenderHint(QPainter::Antialiasing, true);
+        painter->setBrush(bgBrush);
+        painter->setPen(QPen(penBrush, PenWidth::Frame));
+        const qreal radius = roundButton ? roundRadius : frameRadius(PenWidth::Frame);
+        painter->drawRoundedRect(frameRect, radius, radius);
+    };
+
+    // round buttons depend on their size, and animated ones change every frame, paint them directly
+    if (!roundButton && bgAnimation == AnimationData::OpacityInvalid && penAnimation == AnimationData::OpacityInvalid) {
+        // a brush without style draws nothing, same as a transparent one
+        const QColor background = bgBrush.style() == Qt::NoBrush ? QColor(Qt::transparent) : bgBrush.color();
+        const QColor pen = penBrush.style() == Qt::NoBrush ? QColor(Qt::transparent) : penBrush.color();
+        const QColor shadowPen = shadow.isValid() ? shadow : QColor(Qt::transparent);
+        const int cornerSize = Metrics::Frame_FrameRadius + 3;
+        if (renderCachedTileSet(painter, rect, {Primitive::ButtonFrame, 0, {background.rgba(), pen.rgba(), shadowPen.rgba()}}, cornerSize, paint)) {
+            return;
+        }
     }
 
-    // Render button
-    painter->setRenderHint(QPainter::Antialiasing, true);
-    painter->setBrush(bgBrush);
-    painter->setPen(QPen(penBrush, PenWidth::Frame));
-    const qreal radius = roundButton ? roundRadius : frameRadius(PenWidth::Frame);
-    painter->drawRoundedRect(frameRect, radius, radius);
+    paint(painter, rect);
 }
 
 //______________________________________________________________________________
@@ -839,38 +990,51 @@ void Helper::renderCheckBoxBackground(QPainter *painter,
     // setup painter
     painter->setRenderHint(QPainter::Antialiasing, true);
 
-    // copy rect
-    QRectF frameRect(rect);
-    frameRect.adjust(2, 2, -2, -2);
-    frameRect = strokedRect(frameRect);
-
     auto transparent = neutalHighlight ? neutralText(palette) : palette.highlight().color();
     transparent.setAlphaF(highlightBackgroundAlpha);
 
-    QBrush penBrush;
+    QColor penColor;
     if (neutalHighlight) {
-        penBrush = neutralText(palette);
+        penColor = neutralText(palette);
     } else if (state == CheckOn || state == CheckPartial) {
-        penBrush = palette.highlight().color();
+        penColor = palette.highlight().color();
     } else {
-        penBrush = separatorColor(palette);
+        penColor = separatorColor(palette);
     }
-    painter->setPen(QPen(penBrush, PenWidth::Frame));
 
-    const auto radius = Metrics::CheckBox_Radius;
+    const QColor background = palette.button().color().darker(sunken ? radioCheckSunkenDarkeningFactor : 100);
 
-    painter->setBrush(palette.button().color().darker(sunken ? radioCheckSunkenDarkeningFactor : 100));
-    painter->drawRoundedRect(frameRect, radius, radius);
+    const auto paint = [&](QPainter *painter, const QRectF &rect) {
+        painter->setRenderHint(QPainter::Antialiasing, true);
+
+        // copy rect
+        QRectF frameRect(rect);
+        frameRect.adjust(2, 2, -2, -2);
+        frameRect = strokedRect(frameRect);
+
+        painter->setPen(QPen(penColor, PenWidth::Frame));
+
+        const auto radius = Metrics::CheckBox_Radius;
 
-    if (state == CheckOff) {
+        painter->setBrush(background);
+        painter->drawRoundedRect(frameRect, radius, radius);
+
+        if (state == CheckOff) {
+            return;
+        }
+
+        painter->setBrush(transparent);
+        if (state == CheckAnimated) {
+            painter->setOpacity(animation);
+        }
+        painter->drawRoundedRect(frameRect, radius, radius);
+    };
+
+    if (state != CheckAnimated && renderCachedPixmap(painter, rect, {Primitive::CheckBoxBackground, state, {penColor.rgba(), background.rgba(), transparent.rgba()}}, paint)) {
         return;
     }
 
-    painter->setBrush(transparent);
-    if (state == CheckAnimated) {
-        painter->setOpacity(animation);
-    }
-    painter->drawRoundedRect(frameRect, radius, radius);
+    paint(painter, rect);
 }
 
 //______________________________________________________________________________
@@ -890,71 +1054,60 @@ void Helper::renderCheckBox(QPainter *painter,
     // setup painter
     painter->setRenderHint(QPainter::Antialiasing, true);
 
-    // copy rect and radius
-    QRectF frameRect(rect);
-    frameRect.adjust(2, 2, -2, -2);
+    const QColor ringColor = mouseOver ? (neutalHighlight ? neutralText(palette).lighter() : focusColor(palette)) : QColor();
 
-    if (mouseOver) {
-        painter->save();
+    const auto paint = [&](QPainter *painter, const QRectF &rect) {
+        painter->setRenderHint(QPainter::Antialiasing, true);
 
-        if (hoverAnimation != AnimationData::OpacityInvalid) {
-            painter->setOpacity(hoverAnimation);
-        }
+        // copy rect and radius
+        QRectF frameRect(rect);
+        frameRect.adjust(2, 2, -2, -2);
 
-        painter->setPen(QPen(neutalHighlight ? neutralText(palette).lighter() : focusColor(palette), PenWidth::Frame));
-        painter->setBrush(Qt::NoBrush);
+        if (mouseOver) {
+            painter->save();
 
-        painter->drawRoundedRect(frameRect.adjusted(0.5, 0.5, -0.5, -0.5), Metrics::CheckBox_Radius, Metrics::CheckBox_Radius);
+            if (hoverAnimation != AnimationData::OpacityInvalid) {
+                painter->setOpacity(hoverAnimation);
+            }
 
-        painter->restore();
-    }
+            painter->setPen(QPen(ringColor, PenWidth::Frame));
+            painter->setBrush(Qt::NoBrush);
 
-    // check
-    auto leftPoint = frameRect.center();
-    leftPoint.setX(frameRect.left() + 4);
+            painter->drawRoundedRect(frameRect.adjusted(0.5, 0.5, -0.5, -0.5), Metrics::CheckBox_Radius, Metrics::CheckBox_Radius);
 
-    auto bottomPoint = frameRect.center();
-    bottomPoint.setX(bottomPoint.x() - 1);
-    bottomPoint.setY(frameRect.bottom() - 5);
+            painter->restore();
+        }
 
-    auto rightPoint = frameRect.center();
-    rightPoint.setX(rightPoint.x() + 4.5);
-    rightPoint.setY(frameRect.top() + 5.5);
+        // check
+        auto leftPoint = frameRect.center();
+        leftPoint.setX(frameRect.left() + 4);
 
-    QPainterPath path;
-    path.moveTo(leftPoint);
-    path.lineTo(bottomPoint);
-    path.lineTo(rightPoint);
+        auto bottomPoint = frameRect.center();
+        bottomPoint.setX(bottomPoint.x() - 1);
+        bottomPoint.setY(frameRect.bottom() - 5);
 
-    // dots
-    auto centerDot = QRectF(frameRect.center(), QSize(2, 2));
-    centerDot.adjust(-1, -1, -1, -1);
-    auto leftDot = centerDot.adjusted(-4, 0, -4, 0);
-    auto rightDot = centerDot.adjusted(4, 0, 4, 0);
+        auto rightPoint = frameRect.center();
+        rightPoint.setX(rightPoint.x() + 4.5);
+        rightPoint.setY(frameRect.top() + 5.5);
 
-    painter->setPen(Qt::transparent);
-    painter->setBrush(Qt::transparent);
+        QPainterPath path;
+        path.moveTo(leftPoint);
+        path.lineTo(bottomPoint);
+        path.lineTo(rightPoint);
 
-    auto checkPen = QPen(palette.text(), PenWidth::Frame * 2);
-    checkPen.setJoinStyle(Qt::MiterJoin);
+        // dots
+        auto centerDot = QRectF(frameRect.center(), QSize(2, 2));
+        centerDot.adjust(-1, -1, -1, -1);
+        auto leftDot = centerDot.adjusted(-4, 0, -4, 0);
+        auto rightDot = centerDot.adjusted(4, 0, 4, 0);
 
-    switch (state) {
-    case CheckOff:
-        break;
-    case CheckOn:
-        painter->setPen(checkPen);
-        painter->drawPath(path);
-        break;
-    case CheckPartial:
-        painter->setBrush(palette.text());
-        painter->drawRect(leftDot);
-        painter->drawRect(centerDot);
-        painter->drawRect(rightDot);
-        break;
-    case CheckAnimated:
-        checkPen.setDashPattern({path.length() * animation, path.length()});
+        painter->setPen(Qt::transparent);
+        painter->setBrush(Qt::transparent);
+
+        auto checkPen = QPen(palette.text(), PenWidth::Frame * 2);
+        checkPen.setJoinStyle(Qt::MiterJoin);
 
-        switch (target) {
+        switch (state) {
         case CheckOff:
             break;
         case CheckOn:
@@ -962,21 +1115,46 @@ void Helper::renderCheckBox(QPainter *painter,
             painter->drawPath(path);
             break;
         case CheckPartial:
-            if (animation >= 3.0 / 3.0) {
-                painter->drawRect(rightDot);
-            }
-            if (animation >= 2.0 / 3.0) {
-                painter->drawRect(centerDot);
-            }
-            if (animation >= 1.0 / 3.0) {
-                painter->drawRect(leftDot);
-            }
+            painter->setBrush(palette.text());
+            painter->drawRect(leftDot);
+            painter->drawRect(centerDot);
+            painter->drawRect(rightDot);
             break;
         case CheckAnimated:
+            checkPen.setDashPattern({path.length() * animation, path.length()});
+
+            switch (target) {
+            case CheckOff:
+                break;
+            case CheckOn:
+                painter->setPen(checkPen);
+                painter->drawPath(path);
+                break;
+            case CheckPartial:
+                if (animation >= 3.0 / 3.0) {
+                    painter->drawRect(rightDot);
+                }
+                if (animation >= 2.0 / 3.0) {
+                    painter->drawRect(centerDot);
+                }
+                if (animation >= 1.0 / 3.0) {
+                    painter->drawRect(leftDot);
+                }
+                break;
+            case CheckAnimated:
+                break;
+            }
             break;
         }
-        break;
+    };
+
+    // only fully drawn marks are cached, and only for plain text colors
+    if (state != CheckAnimated && (!mouseOver || hoverAnimation == AnimationData::OpacityInvalid) && palette.text().style() == Qt::SolidPattern
+        && renderCachedPixmap(painter, rect, {Primitive::CheckBox, state | (mouseOver ? 0x100 : 0), {ringColor.rgba(), palette.text().color().rgba()}}, paint)) {
+        return;
     }
+
+    paint(painter, rect);
 }
 
 //______________________________________________________________________________
@@ -991,36 +1169,50 @@ void Helper::renderRadioButtonBackground(QPainter *painter,
     // setup painter
     painter->setRenderHint(QPainter::Antialiasing, true);
 
-    // copy rect
-    QRectF frameRect(rect);
-    frameRect.adjust(2, 2, -2, -2);
-    frameRect.adjust(0.5, 0.5, -0.5, -0.5);
-
     auto transparent = neutalHighlight ? neutralText(palette) : palette.highlight().color();
     transparent.setAlphaF(highlightBackgroundAlpha);
 
-    QBrush penBrush;
+    QColor penColor;
     if (neutalHighlight) {
-        penBrush = neutralText(palette);
+        penColor = neutralText(palette);
     } else if (state == RadioOn) {
-        penBrush = palette.highlight().color();
+        penColor = palette.highlight().color();
     } else {
-        penBrush = separatorColor(palette);
+        penColor = separatorColor(palette);
     }
-    painter->setPen(QPen(penBrush, PenWidth::Frame));
 
-    painter->setBrush(palette.button().color().darker(sunken ? radioCheckSunkenDarkeningFactor : 100));
-    painter->drawEllipse(frameRect);
+    const QColor background = palette.button().color().darker(sunken ? radioCheckSunkenDarkeningFactor : 100);
+
+    const auto paint = [&](QPainter *painter, const QRectF &rect) {
+        painter->setRenderHint(QPainter::Antialiasing, true);
 
-    if (state == RadioOff) {
+        // copy rect
+        QRectF frameRect(rect);
+        frameRect.adjust(2, 2, -2, -2);
+        frameRect.adjust(0.5, 0.5, -0.5, -0.5);
+
+        painter->setPen(QPen(penColor, PenWidth::Frame));
+
+        painter->setBrush(background);
+        painter->drawEllipse(frameRect);
+
+        if (state == RadioOff) {
+            return;
+        }
+
+        painter->setBrush(transparent);
+        if (state == RadioAnimated) {
+            painter->setOpacity(animation);
+        }
+        painter->drawEllipse(frameRect);
+    };
+
+    if (state != RadioAnimated
+        && renderCachedPixmap(painter, rect, {Primitive::RadioButtonBackground, state, {penColor.rgba(), background.rgba(), transparent.rgba()}}, paint)) {
         return;
     }
 
-    painter->setBrush(transparent);
-    if (state == RadioAnimated) {
-        painter->setOpacity(animation);
-    }
-    painter->drawEllipse(frameRect);
+    paint(painter, rect);
 }
 
 //______________________________________________________________________________
@@ -1036,45 +1228,62 @@ void Helper::renderRadioButton(QPainter *painter,
 {
     Q_UNUSED(sunken)
 
-    // copy rect
-    QRectF frameRect(rect);
-    frameRect.adjust(1, 1, -1, -1);
+    // setup painter
+    painter->setRenderHint(QPainter::Antialiasing, true);
 
-    if (mouseOver) {
-        painter->save();
+    const QColor ringColor = mouseOver ? (neutralHighlight ? neutralText(palette).lighter() : focusColor(palette)) : QColor();
 
-        if (animationHover != AnimationData::OpacityInvalid) {
-            painter->setOpacity(animationHover);
-        }
+    const auto paint = [&](QPainter *painter, const QRectF &rect) {
+        painter->setRenderHint(QPainter::Antialiasing, true);
 
-        painter->setPen(QPen(neutralHighlight ? neutralText(palette).lighter() : focusColor(palette), PenWidth::Frame));
-        painter->setBrush(Qt::NoBrush);
+        // copy rect
+        QRectF frameRect(rect);
+        frameRect.adjust(1, 1, -1, -1);
 
-        const QRectF contentRect(frameRect.adjusted(1, 1, -1, -1).adjusted(0.5, 0.5, -0.5, -0.5));
-        painter->drawEllipse(contentRect);
+        if (mouseOver) {
+            painter->save();
 
-        painter->restore();
-    }
+            if (animationHover != AnimationData::OpacityInvalid) {
+                painter->setOpacity(animationHover);
+            }
 
-    painter->setBrush(palette.text());
-    painter->setPen(Qt::NoPen);
+            painter->setPen(QPen(ringColor, PenWidth::Frame));
+            painter->setBrush(Qt::NoBrush);
 
-    const int radius = (std::min(frameRect.width(), frameRect.height()) - 12) / 2;
-    const QPointF center = frameRect.center();
+            const QRectF contentRect(frameRect.adjusted(1, 1, -1, -1).adjusted(0.5, 0.5, -0.5, -0.5));
+            painter->drawEllipse(contentRect);
 
-    // mark
-    switch (state) {
-    case RadioOn:
-        painter->drawEllipse(center, radius, radius);
-        break;
-    case RadioAnimated: {
-        const qreal animationRadius = radius * animation;
-        painter->drawEllipse(center, animationRadius, animationRadius);
-        break;
-    }
-    default:
-        break;
+            painter->restore();
+        }
+
+        painter->setBrush(palette.text());
+        painter->setPen(Qt::NoPen);
+
+        const int radius = (std::min(frameRect.width(), frameRect.height()) - 12) / 2;
+        const QPointF center = frameRect.center();
+
+        // mark
+        switch (state) {
+        case RadioOn:
+            painter->drawEllipse(center, radius, radius);
+            break;
+        case RadioAnimated: {
+            const qreal animationRadius = radius * animation;
+            painter->drawEllipse(center, animationRadius, animationRadius);
+            break;
+        }
+        default:
+            break;
+        }
+    };
+
+    // only fully drawn marks are cached, and only for plain text colors
+    if (state != RadioAnimated && (!mouseOver || animationHover == AnimationData::OpacityInvalid) && palette.text().style() == Qt::SolidPattern
+        && renderCachedPixmap(painter, rect, {Primitive::RadioButton, state | (mouseOver ? 0x100 : 0), {ringColor.rgba(), palette.text().color().rgba()}}, paint)) {
+        return;
     }
+
+    paint(painter, rect);
 }
 
 //______________________________________________________________________________
@@ -1166,38 +1375,58 @@ QRectF Helper::pathForSliderHandleFocusFrame(QPainterPath &focusFramePath, const
 }
 
 //______________________________________________________________________________
-void Helper::renderSliderHandle(QPainter *painter, const QRectF &rect, const QColor &color, const QColor &outline, const QColor &shadow, bool sunken) const
+void Helper::renderSliderHandle(QPainter *painter,
+                                const QRectF &rect,
+                                const QColor &color,
+                                const QColor &outline,
+                                const QColor &shadow,
+                                bool sunken,
+                                bool animated) const
 {
     // setup painter
     painter->setRenderHint(QPainter::Antialiasing, true);
 
-    // copy rect
-    QRectF frameRect(rect);
-    frameRect.adjust(1, 1, -1, -1);
+    const auto paint = [&](QPainter *painter, const QRectF &rect) {
+        painter->setRenderHint(QPainter::Antialiasing, true);
 
-    // shadow
-    if (!sunken) {
-        renderEllipseShadow(painter, frameRect, shadow);
-    }
+        // copy rect
+        QRectF frameRect(rect);
+        frameRect.adjust(1, 1, -1, -1);
 
-    // set pen
-    if (outline.isValid()) {
-        painter->setPen(QPen(outline, PenWidth::Frame));
-        frameRect = strokedRect(frameRect);
+        // shadow
+        if (!sunken) {
+            renderEllipseShadow(painter, frameRect, shadow);
+        }
 
-    } else {
-        painter->setPen(Qt::NoPen);
-    }
+        // set pen
+        if (outline.isValid()) {
+            painter->setPen(QPen(outline, PenWidth::Frame));
+            frameRect = strokedRect(frameRect);
 
-    // set brush
-    if (color.isValid()) {
-        painter->setBrush(color);
-    } else {
-        painter->setBrush(Qt::NoBrush);
+        } else {
+            painter->setPen(Qt::NoPen);
+        }
+
+        // set brush
+        if (color.isValid()) {
+            painter->setBrush(color);
+        } else {
+            painter->setBrush(Qt::NoBrush);
+        }
+
+        // render
+        painter->drawEllipse(frameRect);
+    };
+
+    if (!animated) {
+        // invalid colors are not drawn at all, and an invalid outline changes the geometry
+        const int state = (sunken ? 0x1 : 0) | (color.isValid() ? 0x2 : 0) | (outline.isValid() ? 0x4 : 0) | (shadow.isValid() ? 0x8 : 0);
+        if (renderCachedPixmap(painter, rect, {Primitive::SliderHandle, state, {color.rgba(), outline.rgba(), shadow.rgba()}}, paint)) {
+            return;
+        }
     }
 
-    // render
-    painter->drawEllipse(frameRect);
+    paint(painter, rect);
 }
 
 //______________________________________________________________________________
@@ -1299,24 +1528,24 @@ void Helper::renderScrollBarBorder(QPainter *painter, const QRectF &rect, const
 void Helper::renderStaticTabBarTab(QPainter *painter,
                                    const QRectF &rect,
                                    const QPalette &palette,
-                                   const QHash<QByteArray, bool> &stateProperties,
+                                   StateProperties stateProperties,
                                    Corners corners,
                                    qreal animation) const
 {
-    bool enabled = stateProperties.value("enabled", true);
-    bool hovered = stateProperties.value("hovered");
-    bool selected = stateProperties.value("selected");
-    bool documentMode = stateProperties.value("documentMode");
-    bool north = stateProperties.value("north");
-    bool south = stateProperties.value("south");
-    bool west = stateProperties.value("west");
-    bool east = stateProperties.value("east");
-    bool isFirst = stateProperties.value("isFirst");
-    bool isLast = stateProperties.value("isLast");
-    bool isRightOfSelected = stateProperties.value("isRightOfSelected");
+    bool enabled = stateProperties.testFlag(StateEnabled);
+    bool hovered = stateProperties.testFlag(StateHovered);
+    bool selected = stateProperties.testFlag(StateSelected);
+    bool documentMode = stateProperties.testFlag(StateDocumentMode);
+    bool north = stateProperties.testFlag(StateNorth);
+    bool south = stateProperties.testFlag(StateSouth);
+    bool west = stateProperties.testFlag(StateWest);
+    bool east = stateProperties.testFlag(StateEast);
+    bool isFirst = stateProperties.testFlag(StateFirst);
+    bool isLast = stateProperties.testFlag(StateLast);
+    bool isRightOfSelected = stateProperties.testFlag(StateRightOfSelected);
     bool animated = animation != AnimationData::OpacityInvalid;
-    bool isQtQuickControl = stateProperties.value("isQtQuickControl");
-    bool hasAlteredBackground = stateProperties.value("hasAlteredBackground");
+    bool isQtQuickControl = stateProperties.testFlag(StateQtQuickControl);
+    bool hasAlteredBackground = stateProperties.testFlag(StateAlteredBackground);
     const auto baseColor = palette.color(QPalette::Base).darker(102);
     const auto windowColor = palette.color(QPalette::Window);
 
@@ -1432,21 +1661,21 @@ void Helper::renderStaticTabBarTab(QPainter *painter,
 void Helper::renderTabBarTab(QPainter *painter,
                              const QRectF &rect,
                              const QPalette &palette,
-                             const QHash<QByteArray, bool> &stateProperties,
+                             StateProperties stateProperties,
                              Corners corners,
                              qreal animation) const
 {
-    bool enabled = stateProperties.value("enabled", true);
-    bool hovered = stateProperties.value("hovered");
-    bool selected = stateProperties.value("selected");
-    bool documentMode = stateProperties.value("documentMode");
-    bool north = stateProperties.value("north");
-    bool south = stateProperties.value("south");
-    bool west = stateProperties.value("west");
-    bool east = stateProperties.value("east");
+    bool enabled = stateProperties.testFlag(StateEnabled);
+    bool hovered = stateProperties.testFlag(StateHovered);
+    bool selected = stateProperties.testFlag(StateSelected);
+    bool documentMode = stateProperties.testFlag(StateDocumentMode);
+    bool north = stateProperties.testFlag(StateNorth);
+    bool south = stateProperties.testFlag(StateSouth);
+    bool west = stateProperties.testFlag(StateWest);
+    bool east = stateProperties.testFlag(StateEast);
     bool animated = animation != AnimationData::OpacityInvalid;
-    bool isQtQuickControl = stateProperties.value("isQtQuickControl");
-    bool hasAlteredBackground = stateProperties.value("hasAlteredBackground");
+    bool isQtQuickControl = stateProperties.testFlag(StateQtQuickControl);
+    bool hasAlteredBackground = stateProperties.testFlag(StateAlteredBackground);
 
     // setup painter
     painter->setRenderHint(QPainter::Antialiasing, true);
@@ -1508,7 +1737,7 @@ void Helper::renderTabBarTab(QPainter *painter,
 }
 
 //______________________________________________________________________________
-void Helper::renderArrow(QPainter *painter, const QRectF &rect, const QColor &color, ArrowOrientation orientation) const
+void Helper::renderArrow(QPainter *painter, const QRectF &rect, const QColor &color, ArrowOrientation orientation, bool animated) const
 {
     int size = std::min({rect.toRect().width(), rect.toRect().height(), Metrics::ArrowSize});
     // No point in trying to draw if it's too small
@@ -1564,17 +1793,26 @@ void Helper::renderArrow(QPainter *painter, const QRectF &rect, const QColor &co
         break;
     }
 
-    arrow.translate(rect.x() + (rect.width() - size) / 2.0, rect.y() + (rect.height() - size) / 2.0);
+    // arrow box, centered in rect, with room for the pen joins around it
+    const QRectF arrowRect(rect.x() + (rect.width() - size) / 2.0 - 1, rect.y() + (rect.height() - size) / 2.0 - 1, size + 2, size + 2);
 
-    painter->save();
-    painter->setRenderHints(QPainter::Antialiasing);
-    painter->setBrush(Qt::NoBrush);
-    QPen pen(color, PenWidth::Symbol);
-    pen.setCapStyle(Qt::SquareCap);
-    pen.setJoinStyle(Qt::MiterJoin);
-    painter->setPen(pen);
-    painter->drawPolyline(arrow);
-    painter->restore();
+    const auto paint = [&](QPainter *painter, const QRectF &rect) {
+        painter->save();
+        painter->setRenderHints(QPainter::Antialiasing);
+        painter->setBrush(Qt::NoBrush);
+        QPen pen(color, PenWidth::Symbol);
+        pen.setCapStyle(Qt::SquareCap);
+        pen.setJoinStyle(Qt::MiterJoin);
+        painter->setPen(pen);
+        painter->drawPolyline(arrow.translated(rect.topLeft() + QPointF(1, 1)));
+        painter->restore();
+    };
+
+    if (!animated && renderCachedPixmap(painter, arrowRect, {Primitive::Arrow, orientation, {color.rgba()}}, paint)) {
+        return;
+    }
+
+    paint(painter, arrowRect);
 }
 
 //______________________________________________________________________________
@@ -9,18 +9,24 @@
 #include "breeze.h"
 #include "breezeanimationdata.h"
 #include "breezemetrics.h"
+#include "breezetileset.h"
 
 #include <KConfigWatcher>
 #include <KSharedConfig>
 #include <KStatefulBrush>
 
+#include <QCache>
 #include <QIcon>
 #include <QPainterPath>
+#include <QPair>
+#include <QPixmap>
 #include <QStyleOptionViewItem>
 #include <QToolBar>
 #include <QWidget>
 #include <qpainter.h>
 
+#include <array>
+
 class QSlider;
 class QStyleOptionSlider;
 
@@ -63,13 +69,13 @@ public:
     //* mouse over color
     QColor hoverColor(const QPalette &palette) const
     {
-        return _viewHoverBrush.brush(palette).color();
+        return derivedColors(palette).hover;
     }
 
     //* focus color
     QColor focusColor(const QPalette &palette) const
     {
-        return _viewFocusBrush.brush(palette).color();
+        return derivedColors(palette).focus;
     }
 
     //* negative text color (used for close button)
@@ -199,7 +205,7 @@ public:
     void renderButtonFrame(QPainter *painter,
                            const QRectF &rect,
                            const QPalette &palette,
-                           const QHash<QByteArray, bool> &stateProperties,
+                           StateProperties stateProperties,
                            qreal bgAnimation = AnimationData::OpacityInvalid,
                            qreal penAnimation = AnimationData::OpacityInvalid) const;
 
@@ -262,8 +268,8 @@ public:
     //* slider focus frame
     QRectF pathForSliderHandleFocusFrame(QPainterPath &, const QRectF &, int hmargin, int vmargin) const;
 
-    //* slider handle
-    void renderSliderHandle(QPainter *, const QRectF &, const QColor &, const QColor &outline, const QColor &shadow, bool sunken) const;
+    //* slider handle, animated handles are not cached
+    void renderSliderHandle(QPainter *, const QRectF &, const QColor &, const QColor &outline, const QColor &shadow, bool sunken, bool animated = false) const;
 
     //* dial groove
     void renderDialGroove(QPainter *, const QRectF &, const QColor &fg, const QColor &bg, qreal first, qreal last) const;
@@ -287,12 +293,11 @@ public:
     void renderScrollBarBorder(QPainter *, const QRectF &, const QColor &) const;
 
     //* tabbar tab
-    void renderTabBarTab(QPainter *, const QRectF &, const QPalette &palette, const QHash<QByteArray, bool> &stateProperties, Corners corners, qreal animation)
-        const;
+    void renderTabBarTab(QPainter *, const QRectF &, const QPalette &palette, StateProperties stateProperties, Corners corners, qreal animation) const;
     void renderStaticTabBarTab(QPainter *,
                                const QRectF &,
                                const QPalette &palette,
-                               const QHash<QByteArray, bool> &stateProperties,
+                               StateProperties stateProperties,
                                Corners corners,
                                qreal animation) const;
     // TODO(janet): document should be set based on whether or not we consider the
@@ -300,8 +305,8 @@ public:
     // so we're currently just always setting it to true for now
     qreal devicePixelRatio(QPainter *) const;
 
-    //* generic arrow
-    void renderArrow(QPainter *, const QRectF &, const QColor &, ArrowOrientation) const;
+    //* generic arrow, animated arrows are not cached
+    void renderArrow(QPainter *, const QRectF &, const QColor &, ArrowOrientation, bool animated = false) const;
 
     //* generic button (for mdi decorations, tabs and dock widgets)
     void renderDecorationButton(QPainter *, const QRectF &, const QColor &, ButtonType, bool inverted) const;
@@ -319,6 +324,9 @@ public:
                                 const QBrush &bg,
                                 const QColor &outline) const;
 
+    //* byte budget of the rendered primitive cache, 8 MiB by default
+    void setPrimitiveCacheMaxBytes(qint64 bytes);
+
     //@}
 
     //*@name compositing utilities
@@ -378,6 +386,108 @@ protected:
     QPainterPath roundedPath(const QRectF &, Corners, qreal) const;
 
 private:
+    //*@name rendered primitive cache
+    //@{
+
+    //* primitives rendered through the cache
+    enum class Primitive {
+        CheckBoxBackground,
+        CheckBox,
+        RadioButtonBackground,
+        RadioButton,
+        SliderHandle,
+        Arrow,
+        ButtonFrame,
+    };
+
+    /**
+     * everything a rendered primitive depends on
+     * size and offset are filled in by the cache, the offset being the position of the rect within whole pixels
+     **/
+    struct PrimitiveKey {
+        Primitive primitive;
+        int state = 0;
+        std::array<QRgb, 3> colors = {};
+        QSizeF size;
+        QPointF offset;
+        qreal devicePixelRatio = 1;
+
+        friend bool operator==(const PrimitiveKey &lhs, const PrimitiveKey &rhs)
+        {
+            return lhs.primitive == rhs.primitive && lhs.state == rhs.state && lhs.colors == rhs.colors && lhs.size == rhs.size && lhs.offset == rhs.offset
+                && lhs.devicePixelRatio == rhs.devicePixelRatio;
+        }
+
+        friend size_t qHash(const PrimitiveKey &key, size_t seed = 0)
+        {
+            size_t hash = qHash(static_cast<int>(key.primitive), seed);
+            hash = hash * 31 + qHash(key.state);
+            for (const QRgb color : key.colors) {
+                hash = hash * 31 + qHash(color);
+            }
+            hash = hash * 31 + qHash(key.size.width());
+            hash = hash * 31 + qHash(key.size.height());
+            hash = hash * 31 + qHash(key.offset.x());
+            hash = hash * 31 + qHash(key.offset.y());
+            return hash * 31 + qHash(key.devicePixelRatio);
+        }
+    };
+
+    //* rendered primitive, a pixmap for fixed size indicators or a tileset for resizable frames
+    struct CachedPrimitive {
+        QPixmap pixmap;
+        TileSet tileSet;
+    };
+
+    //* true if blitting a cached primitive gives the same pixels as painting it
+    bool canUsePrimitiveCache(QPainter *) const;
+
+    /**
+     * render a fixed size primitive as a cached pixmap
+     * paint renders the primitive in the given rect of the given painter
+     * returns false, without painting anything, if the painter cannot use the cache
+     **/
+    template<typename Paint>
+    bool renderCachedPixmap(QPainter *, const QRectF &, PrimitiveKey, Paint paint) const;
+
+    /**
+     * render a resizable frame as a cached tileset
+     * the corners span cornerSize pixels, sides must be straight beyond them
+     * returns false, without painting anything, if the painter or the rect cannot use the cache
+     **/
+    template<typename Paint>
+    bool renderCachedTileSet(QPainter *, const QRectF &, PrimitiveKey, int cornerSize, Paint paint) const;
+
+    //* rendered primitives, the cost is in kilobytes
+    mutable QCache<PrimitiveKey, CachedPrimitive> _primitiveCache;
+
+    //@}
+
+    //*@name derived colors
+    //@{
+
+    //* colors derived from the current color group of a palette
+    struct DerivedColors {
+        QColor hover;
+        QColor focus;
+
+        //* window and window text mix, for frames and separators
+        QColor frameOutline;
+
+        //* button and button text mix, for buttons and slider handles
+        QColor buttonOutline;
+
+        QColor checkBoxIndicator;
+    };
+
+    //* derived colors for the palette current color group, computed once per palette
+    DerivedColors derivedColors(const QPalette &) const;
+
+    //* derived colors of the palettes in use, by palette cache key and color group
+    mutable QCache<QPair<qint64, int>, DerivedColors> _derivedColors;
+
+    //@}
+
     //* configuration
     KSharedConfig::Ptr _config;
 
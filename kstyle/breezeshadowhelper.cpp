@@ -11,6 +11,7 @@
 #include "breezehelper.h"
 #include "breezemetrics.h"
 #include "breezepropertynames.h"
+#include "breezeshadowcache.h"
 #include "breezestyleconfigdata.h"
 
 #include <KWindowSystem>
@@ -131,6 +132,8 @@ void ShadowHelper::unregisterWidget(QWidget *widget)
 //_______________________________________________________
 void ShadowHelper::loadConfig()
 {
+    ShadowCache::self().setMaxBytes(qint64(StyleConfigData::shadowCacheSize()) * 1024 * 1024);
+
     // reset
     reset();
 
@@ -211,32 +214,30 @@ TileSet ShadowHelper::shadowTiles(QWidget *widget)
     shadowRenderer.addShadow(params.shadow1.offset, params.shadow1.radius, withOpacity(color, params.shadow1.opacity * strength));
     shadowRenderer.addShadow(params.shadow2.offset, params.shadow2.radius, withOpacity(color, params.shadow2.opacity * strength));
 
-    QImage shadowTexture = shadowRenderer.render();
-
-    const QRect outerRect(QPoint(0, 0), shadowTexture.size());
+    const QRect outerRect(QPoint(0, 0), shadowRenderer.textureSize());
 
     QRect boxRect(QPoint(0, 0), boxSize);
     boxRect.moveCenter(outerRect.center());
 
     // Mask out inner rect.
-    QPainter painter(&shadowTexture);
-    painter.setRenderHint(QPainter::Antialiasing);
-
     const QMargins margins = QMargins(boxRect.left() - outerRect.left() - Metrics::Shadow_Overlap - params.offset.x(),
                                       boxRect.top() - outerRect.top() - Metrics::Shadow_Overlap - params.offset.y(),
                                       outerRect.right() - boxRect.right() - Metrics::Shadow_Overlap + params.offset.x(),
                                       outerRect.bottom() - boxRect.bottom() - Metrics::Shadow_Overlap + params.offset.y());
+    shadowRenderer.setCutout(outerRect - margins, frameRadius);
 
-    painter.setPen(Qt::NoPen);
-    painter.setBrush(Qt::black);
-    painter.setCompositionMode(QPainter::CompositionMode_DestinationOut);
-    painter.drawRoundedRect(outerRect - margins, frameRadius, frameRadius);
+    // Render only the tiles, the whole texture is never needed. Tiles are shared
+    // with every other user of the same shadow.
+    const BoxShadowRenderer::Tiles tiles = ShadowCache::self().renderTiles(shadowRenderer);
 
-    // We're done.
-    painter.end();
+    QVector<QPixmap> pixmaps;
+    pixmaps.reserve(BoxShadowRenderer::Tiles::TileCount);
+    for (const QImage &tile : tiles.tiles) {
+        pixmaps.append(QPixmap::fromImage(tile));
+    }
 
-    const QPoint innerRectTopLeft = outerRect.center();
-    _shadowTiles = TileSet(QPixmap::fromImage(std::move(shadowTexture)), innerRectTopLeft.x(), innerRectTopLeft.y(), 1, 1);
+    // We're done.
+    _shadowTiles = TileSet(pixmaps);
 
     return _shadowTiles;
 }
@@ -2158,6 +2158,9 @@ void Style::loadConfiguration()
     // clear icon cache
     _iconCache.clear();
 
+    // rendered primitive cache
+    _helper->setPrimitiveCacheMaxBytes(qint64(StyleConfigData::primitiveCacheSize()) * 1024);
+
     // scrollbar buttons
     switch (StyleConfigData::scrollBarAddLineButtons()) {
     case 0:
@@ -4392,8 +4395,9 @@ bool Style::drawIndicatorArrowPrimitive(ArrowOrientation orientation, const QSty
     const bool inTabBar(widget && qobject_cast<const QTabBar *>(widget->parentWidget()));
     const bool inToolButton(qstyleoption_cast<const QStyleOptionToolButton *>(option));
 
-    // color
+    // color, and whether it is fading
     QColor color;
+    bool animated(false);
     if (inTabBar) {
         // for tabbar arrows one uses animations to get the arrow color
         /*
@@ -4402,6 +4406,7 @@ bool Style::drawIndicatorArrowPrimitive(ArrowOrientation orientation, const QSty
          */
         const AnimationMode mode(_animations->widgetStateEngine().buttonAnimationMode(widget));
         const qreal opacity(_animations->widgetStateEngine().buttonOpacity(widget));
+        animated = mode != AnimationNone;
         color = _helper->arrowColor(palette, mouseOver, hasFocus, opacity, mode);
 
     } else if (mouseOver && !inToolButton) {
@@ -4429,7 +4434,7 @@ bool Style::drawIndicatorArrowPrimitive(ArrowOrientation orientation, const QSty
                 // handle arrow over animation
                 _animations->toolButtonEngine().updateState(widget, AnimationHover, arrowHover);
 
-                const bool animated(_animations->toolButtonEngine().isAnimated(widget, AnimationHover));
+                animated = _animations->toolButtonEngine().isAnimated(widget, AnimationHover);
                 const qreal opacity(_animations->toolButtonEngine().opacity(widget, AnimationHover));
 
                 color = _helper->arrowColor(palette, arrowHover, false, opacity, animated ? AnimationHover : AnimationNone);
@@ -4454,7 +4459,7 @@ bool Style::drawIndicatorArrowPrimitive(ArrowOrientation orientation, const QSty
     }
 
     // render
-    _helper->renderArrow(painter, rect, color, orientation);
+    _helper->renderArrow(painter, rect, color, orientation, animated);
 
     return true;
 }
@@ -4537,18 +4542,18 @@ bool Style::drawPanelButtonCommandPrimitive(const QStyleOption *option, QPainter
     qreal bgAnimation = _animations->widgetStateEngine().opacity(widget, AnimationFocus);
     qreal penAnimation = _animations->widgetStateEngine().opacity(widget, AnimationHover);
 
-    QHash<QByteArray, bool> stateProperties;
-    stateProperties["enabled"] = enabled;
-    stateProperties["visualFocus"] = visualFocus;
-    stateProperties["hovered"] = hovered;
-    stateProperties["down"] = down;
-    stateProperties["checked"] = checked;
-    stateProperties["flat"] = flat;
-    stateProperties["hasMenu"] = hasMenu;
-    stateProperties["defaultButton"] = defaultButton;
-    stateProperties["hasNeutralHighlight"] = hasNeutralHighlight;
-    stateProperties["isActiveWindow"] = widget ? widget->isActiveWindow() : true;
-    stateProperties["roundButton"] = roundButton;
+    StateProperties stateProperties;
+    stateProperties.setFlag(StateEnabled, enabled);
+    stateProperties.setFlag(StateVisualFocus, visualFocus);
+    stateProperties.setFlag(StateHovered, hovered);
+    stateProperties.setFlag(StateDown, down);
+    stateProperties.setFlag(StateChecked, checked);
+    stateProperties.setFlag(StateFlat, flat);
+    stateProperties.setFlag(StateHasMenu, hasMenu);
+    stateProperties.setFlag(StateDefaultButton, defaultButton);
+    stateProperties.setFlag(StateNeutralHighlight, hasNeutralHighlight);
+    stateProperties.setFlag(StateActiveWindow, widget ? widget->isActiveWindow() : true);
+    stateProperties.setFlag(StateRoundButton, roundButton);
 
     _helper->renderButtonFrame(painter, option->rect, option->palette, stateProperties, bgAnimation, penAnimation);
 
@@ -4586,15 +4591,15 @@ bool Style::drawPanelButtonToolPrimitive(const QStyleOption *option, QPainter *p
         baseRect = visualRect(option, baseRect);
     }
 
-    QHash<QByteArray, bool> stateProperties;
-    stateProperties["enabled"] = enabled;
-    stateProperties["visualFocus"] = visualFocus;
-    stateProperties["hovered"] = hovered;
-    stateProperties["down"] = down;
-    stateProperties["checked"] = checked;
-    stateProperties["flat"] = flat;
-    stateProperties["hasNeutralHighlight"] = hasNeutralHighlight;
-    stateProperties["isActiveWindow"] = widget ? widget->isActiveWindow() : true;
+    StateProperties stateProperties;
+    stateProperties.setFlag(StateEnabled, enabled);
+    stateProperties.setFlag(StateVisualFocus, visualFocus);
+    stateProperties.setFlag(StateHovered, hovered);
+    stateProperties.setFlag(StateDown, down);
+    stateProperties.setFlag(StateChecked, checked);
+    stateProperties.setFlag(StateFlat, flat);
+    stateProperties.setFlag(StateNeutralHighlight, hasNeutralHighlight);
+    stateProperties.setFlag(StateActiveWindow, widget ? widget->isActiveWindow() : true);
 
     _helper->renderButtonFrame(painter, baseRect, option->palette, stateProperties, bgAnimation, penAnimation);
     if (painter->hasClipping()) {
@@ -5003,15 +5008,15 @@ bool Style::drawIndicatorButtonDropDownPrimitive(const QStyleOption *option, QPa
     baseRect.adjust(-Metrics::Frame_FrameRadius - qRound(PenWidth::Shadow), 0, 0, 0);
     baseRect = visualRect(option, baseRect);
 
-    QHash<QByteArray, bool> stateProperties;
-    stateProperties["enabled"] = enabled;
-    stateProperties["visualFocus"] = visualFocus;
-    stateProperties["hovered"] = hovered;
-    stateProperties["down"] = down;
-    stateProperties["checked"] = checked;
-    stateProperties["flat"] = flat;
-    stateProperties["hasNeutralHighlight"] = hasNeutralHighlight;
-    stateProperties["isActiveWindow"] = widget ? widget->isActiveWindow() : true;
+    StateProperties stateProperties;
+    stateProperties.setFlag(StateEnabled, enabled);
+    stateProperties.setFlag(StateVisualFocus, visualFocus);
+    stateProperties.setFlag(StateHovered, hovered);
+    stateProperties.setFlag(StateDown, down);
+    stateProperties.setFlag(StateChecked, checked);
+    stateProperties.setFlag(StateFlat, flat);
+    stateProperties.setFlag(StateNeutralHighlight, hasNeutralHighlight);
+    stateProperties.setFlag(StateActiveWindow, widget ? widget->isActiveWindow() : true);
 
     _helper->renderButtonFrame(painter, baseRect, option->palette, stateProperties, bgAnimation, penAnimation);
 
@@ -5488,14 +5493,12 @@ bool Style::drawIconButtonControl(const QStyleOption *option, QPainter *painter,
     const qreal bgAnimation = _animations->widgetStateEngine().opacity(widget, AnimationFocus);
     const qreal penAnimation = _animations->widgetStateEngine().opacity(widget, AnimationHover);
 
-    const QHash<QByteArray, bool> stateProperties{
-        {"enabled", enabled},
-        {"visualFocus", visualFocus},
-        {"hovered", hovered},
-        {"down", down},
-        {"isActiveWindow", widget ? widget->isActiveWindow() : true},
-        {"roundButton", true},
-    };
+    StateProperties stateProperties = StateRoundButton;
+    stateProperties.setFlag(StateEnabled, enabled);
+    stateProperties.setFlag(StateVisualFocus, visualFocus);
+    stateProperties.setFlag(StateHovered, hovered);
+    stateProperties.setFlag(StateDown, down);
+    stateProperties.setFlag(StateActiveWindow, widget ? widget->isActiveWindow() : true);
 
     _helper->renderButtonFrame(painter, overlayOption.rect, overlayOption.palette, stateProperties, bgAnimation, penAnimation);
 
@@ -6423,6 +6426,10 @@ bool Style::drawScrollBarAddLineControl(const QStyleOption *option, QPainter *pa
         rect.setLeft(PenWidth::Frame);
     }
 
+    // arrows are not cached while their hover color changes
+    const bool animated(_animations->scrollBarEngine().isAnimated(widget, AnimationHover, SC_ScrollBarAddLine)
+                        || _animations->scrollBarEngine().isAnimated(widget, AnimationHover, SC_ScrollBarSubLine));
+
     QColor color;
     QStyleOptionSlider copy(*sliderOption);
     if (_addLineButtons == DoubleButton) {
@@ -6434,11 +6441,11 @@ bool Style::drawScrollBarAddLineControl(const QStyleOption *option, QPainter *pa
 
             copy.rect = leftSubButton;
             color = scrollBarArrowColor(&copy, reverseLayout ? SC_ScrollBarAddLine : SC_ScrollBarSubLine, widget);
-            _helper->renderArrow(painter, leftSubButton, color, ArrowLeft);
+            _helper->renderArrow(painter, leftSubButton, color, ArrowLeft, animated);
 
             copy.rect = rightSubButton;
             color = scrollBarArrowColor(&copy, reverseLayout ? SC_ScrollBarSubLine : SC_ScrollBarAddLine, widget);
-            _helper->renderArrow(painter, rightSubButton, color, ArrowRight);
+            _helper->renderArrow(painter, rightSubButton, color, ArrowRight, animated);
 
         } else {
             const QSize halfSize(rect.width(), rect.height() / 2);
@@ -6447,11 +6454,11 @@ bool Style::drawScrollBarAddLineControl(const QStyleOption *option, QPainter *pa
 
             copy.rect = topSubButton;
             color = scrollBarArrowColor(&copy, SC_ScrollBarSubLine, widget);
-            _helper->renderArrow(painter, topSubButton, color, ArrowUp);
+            _helper->renderArrow(painter, topSubButton, color, ArrowUp, animated);
 
             copy.rect = botSubButton;
             color = scrollBarArrowColor(&copy, SC_ScrollBarAddLine, widget);
-            _helper->renderArrow(painter, botSubButton, color, ArrowDown);
+            _helper->renderArrow(painter, botSubButton, color, ArrowDown, animated);
         }
 
     } else if (_addLineButtons == SingleButton) {
@@ -6459,13 +6466,13 @@ bool Style::drawScrollBarAddLineControl(const QStyleOption *option, QPainter *pa
         color = scrollBarArrowColor(&copy, SC_ScrollBarAddLine, widget);
         if (horizontal) {
             if (reverseLayout) {
-                _helper->renderArrow(painter, rect, color, ArrowLeft);
+                _helper->renderArrow(painter, rect, color, ArrowLeft, animated);
             } else {
-                _helper->renderArrow(painter, rect.translated(1, 0), color, ArrowRight);
+                _helper->renderArrow(painter, rect.translated(1, 0), color, ArrowRight, animated);
             }
 
         } else {
-            _helper->renderArrow(painter, rect.translated(0, 1), color, ArrowDown);
+            _helper->renderArrow(painter, rect.translated(0, 1), color, ArrowDown, animated);
         }
     }
 
@@ -6502,6 +6509,10 @@ bool Style::drawScrollBarSubLineControl(const QStyleOption *option, QPainter *pa
         rect.setLeft(PenWidth::Frame);
     }
 
+    // arrows are not cached while their hover color changes
+    const bool animated(_animations->scrollBarEngine().isAnimated(widget, AnimationHover, SC_ScrollBarAddLine)
+                        || _animations->scrollBarEngine().isAnimated(widget, AnimationHover, SC_ScrollBarSubLine));
+
     QColor color;
     QStyleOptionSlider copy(*sliderOption);
     if (_subLineButtons == DoubleButton) {
@@ -6513,11 +6524,11 @@ bool Style::drawScrollBarSubLineControl(const QStyleOption *option, QPainter *pa
 
             copy.rect = leftSubButton;
             color = scrollBarArrowColor(&copy, reverseLayout ? SC_ScrollBarAddLine : SC_ScrollBarSubLine, widget);
-            _helper->renderArrow(painter, leftSubButton, color, ArrowLeft);
+            _helper->renderArrow(painter, leftSubButton, color, ArrowLeft, animated);
 
             copy.rect = rightSubButton;
             color = scrollBarArrowColor(&copy, reverseLayout ? SC_ScrollBarSubLine : SC_ScrollBarAddLine, widget);
-            _helper->renderArrow(painter, rightSubButton, color, ArrowRight);
+            _helper->renderArrow(painter, rightSubButton, color, ArrowRight, animated);
 
         } else {
             const QSize halfSize(rect.width(), rect.height() / 2);
@@ -6526,11 +6537,11 @@ bool Style::drawScrollBarSubLineControl(const QStyleOption *option, QPainter *pa
 
             copy.rect = topSubButton;
             color = scrollBarArrowColor(&copy, SC_ScrollBarSubLine, widget);
-            _helper->renderArrow(painter, topSubButton, color, ArrowUp);
+            _helper->renderArrow(painter, topSubButton, color, ArrowUp, animated);
 
             copy.rect = botSubButton;
             color = scrollBarArrowColor(&copy, SC_ScrollBarAddLine, widget);
-            _helper->renderArrow(painter, botSubButton, color, ArrowDown);
+            _helper->renderArrow(painter, botSubButton, color, ArrowDown, animated);
         }
 
     } else if (_subLineButtons == SingleButton) {
@@ -6538,13 +6549,13 @@ bool Style::drawScrollBarSubLineControl(const QStyleOption *option, QPainter *pa
         color = scrollBarArrowColor(&copy, SC_ScrollBarSubLine, widget);
         if (horizontal) {
             if (reverseLayout) {
-                _helper->renderArrow(painter, rect.translated(1, 0), color, ArrowRight);
+                _helper->renderArrow(painter, rect.translated(1, 0), color, ArrowRight, animated);
             } else {
-                _helper->renderArrow(painter, rect, color, ArrowLeft);
+                _helper->renderArrow(painter, rect, color, ArrowLeft, animated);
             }
 
         } else {
-            _helper->renderArrow(painter, rect, color, ArrowUp);
+            _helper->renderArrow(painter, rect, color, ArrowUp, animated);
         }
     }
 
@@ -7337,22 +7348,22 @@ bool Style::drawTabBarTabShapeControl(const QStyleOption *option, QPainter *pain
         break;
     }
 
-    QHash<QByteArray, bool> stateProperties;
-    stateProperties["enabled"] = enabled;
-    stateProperties["visualFocus"] = visualFocus;
-    stateProperties["hovered"] = hovered;
-    stateProperties["down"] = down;
-    stateProperties["selected"] = selected;
-    stateProperties["documentMode"] = true;
-    stateProperties["north"] = north;
-    stateProperties["south"] = south;
-    stateProperties["west"] = west;
-    stateProperties["east"] = east;
-    stateProperties["isRightOfSelected"] = isRightOfSelected;
-    stateProperties["isFirst"] = isFirst;
-    stateProperties["isLast"] = isLast;
-    stateProperties["isQtQuickControl"] = isQtQuickControl;
-    stateProperties["hasAlteredBackground"] = hasAlteredBackground(widget);
+    StateProperties stateProperties;
+    stateProperties.setFlag(StateEnabled, enabled);
+    stateProperties.setFlag(StateVisualFocus, visualFocus);
+    stateProperties.setFlag(StateHovered, hovered);
+    stateProperties.setFlag(StateDown, down);
+    stateProperties.setFlag(StateSelected, selected);
+    stateProperties.setFlag(StateDocumentMode, true);
+    stateProperties.setFlag(StateNorth, north);
+    stateProperties.setFlag(StateSouth, south);
+    stateProperties.setFlag(StateWest, west);
+    stateProperties.setFlag(StateEast, east);
+    stateProperties.setFlag(StateRightOfSelected, isRightOfSelected);
+    stateProperties.setFlag(StateFirst, isFirst);
+    stateProperties.setFlag(StateLast, isLast);
+    stateProperties.setFlag(StateQtQuickControl, isQtQuickControl);
+    stateProperties.setFlag(StateAlteredBackground, hasAlteredBackground(widget));
 
     if (isStatic) {
         _helper->renderStaticTabBarTab(painter, rect, option->palette, stateProperties, corners, animation);
@@ -7839,15 +7850,15 @@ bool Style::drawComboBoxComplexControl(const QStyleOptionComplex *option, QPaint
             qreal bgAnimation = _animations->widgetStateEngine().opacity(widget, AnimationFocus);
             qreal penAnimation = _animations->widgetStateEngine().opacity(widget, AnimationHover);
 
-            QHash<QByteArray, bool> stateProperties;
-            stateProperties["enabled"] = enabled;
-            stateProperties["visualFocus"] = visualFocus;
-            stateProperties["hovered"] = hovered;
+            StateProperties stateProperties;
+            stateProperties.setFlag(StateEnabled, enabled);
+            stateProperties.setFlag(StateVisualFocus, visualFocus);
+            stateProperties.setFlag(StateHovered, hovered);
             // See notes for down and checked above.
-            stateProperties["down"] = down || checked;
-            stateProperties["flat"] = flat;
-            stateProperties["hasNeutralHighlight"] = hasNeutralHighlight;
-            stateProperties["isActiveWindow"] = widget ? widget->isActiveWindow() : true;
+            stateProperties.setFlag(StateDown, down || checked);
+            stateProperties.setFlag(StateFlat, flat);
+            stateProperties.setFlag(StateNeutralHighlight, hasNeutralHighlight);
+            stateProperties.setFlag(StateActiveWindow, widget ? widget->isActiveWindow() : true);
 
             _helper->renderButtonFrame(painter, option->rect, option->palette, stateProperties, bgAnimation, penAnimation);
         }
@@ -7868,6 +7879,7 @@ bool Style::drawComboBoxComplexControl(const QStyleOptionComplex *option, QPaint
 
         // arrow color
         QColor arrowColor;
+        bool animated(false);
         if (editable) {
             if (empty || !enabled) {
                 arrowColor = option->palette.color(QPalette::Disabled, QPalette::Text);
@@ -7876,7 +7888,7 @@ bool Style::drawComboBoxComplexControl(const QStyleOptionComplex *option, QPaint
                 const bool subControlHover(enabled && hovered && option->activeSubControls & SC_ComboBoxArrow);
                 _animations->comboBoxEngine().updateState(widget, AnimationHover, subControlHover);
 
-                const bool animated(enabled && _animations->comboBoxEngine().isAnimated(widget, AnimationHover));
+                animated = enabled && _animations->comboBoxEngine().isAnimated(widget, AnimationHover);
                 const qreal opacity(_animations->comboBoxEngine().opacity(widget, AnimationHover));
 
                 // color
@@ -7911,7 +7923,7 @@ bool Style::drawComboBoxComplexControl(const QStyleOptionComplex *option, QPaint
         auto arrowRect(subControlRect(CC_ComboBox, option, SC_ComboBoxArrow, widget));
 
         // render
-        _helper->renderArrow(painter, arrowRect, arrowColor, ArrowDown);
+        _helper->renderArrow(painter, arrowRect, arrowColor, ArrowDown, animated);
     }
     return true;
 }
@@ -8116,7 +8128,7 @@ bool Style::drawSliderComplexControl(const QStyleOptionComplex *option, QPainter
         const auto shadow(_helper->shadowColor(palette));
 
         // render
-        _helper->renderSliderHandle(painter, handleRect, background, outline, shadow, sunken);
+        _helper->renderSliderHandle(painter, handleRect, background, outline, shadow, sunken, opacity != AnimationData::OpacityInvalid);
     }
 
     return true;
@@ -8190,7 +8202,7 @@ bool Style::drawDialComplexControl(const QStyleOptionComplex *option, QPainter *
         const auto shadow(_helper->shadowColor(palette));
 
         // render
-        _helper->renderSliderHandle(painter, handleRect, background, outline, shadow, sunken);
+        _helper->renderSliderHandle(painter, handleRect, background, outline, shadow, sunken, opacity != AnimationData::OpacityInvalid);
     }
 
     return true;
@@ -8391,7 +8403,7 @@ void Style::renderSpinBoxArrow(const SubControl &subControl, const QStyleOptionS
     const auto arrowRect(subControlRect(CC_SpinBox, option, subControl, widget));
 
     // render
-    _helper->renderArrow(painter, arrowRect, color, orientation);
+    _helper->renderArrow(painter, arrowRect, color, orientation, animated);
 }
 
 //______________________________________________________________________________
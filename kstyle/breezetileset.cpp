@@ -96,6 +96,24 @@ TileSet::TileSet(const QPixmap &source, int w1, int h1, int w2, int h2)
     initPixmap(_pixmaps, source, _w3, _h3, QRect(_w1 + w2, _h1 + h2, _w3, _h3));
 }
 
+//______________________________________________________________
+TileSet::TileSet(const QVector<QPixmap> &pixmaps)
+    : _w1(0)
+    , _h1(0)
+    , _w3(0)
+    , _h3(0)
+{
+    if (pixmaps.size() != 9) {
+        return;
+    }
+
+    _pixmaps = pixmaps;
+    _w1 = pixmaps[0].width() / devicePixelRatio(pixmaps[0]);
+    _h1 = pixmaps[0].height() / devicePixelRatio(pixmaps[0]);
+    _w3 = pixmaps[8].width() / devicePixelRatio(pixmaps[8]);
+    _h3 = pixmaps[8].height() / devicePixelRatio(pixmaps[8]);
+}
+
 //___________________________________________________________
 void TileSet::render(const QRect &constRect, QPainter *painter, Tiles tiles) const
 {
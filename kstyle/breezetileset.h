@@ -32,6 +32,12 @@ public:
     */
     TileSet(const QPixmap &, int w1, int h1, int w2, int h2);
 
+    /**
+    Create a TileSet from nine ready-made pixmaps, ordered top-left, top,
+    top-right, left, center, right, bottom-left, bottom and bottom-right.
+    */
+    explicit TileSet(const QVector<QPixmap> &pixmaps);
+
     //* empty constructor
     TileSet();
 
@@ -0,0 +1,100 @@
+/*
+ * SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "breezeboxshadowrenderer.h"
+
+#include <QTest>
+
+using namespace Breeze;
+
+class AnalyticBackendTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void matchesBoxBlur_data();
+    void matchesBoxBlur();
+
+private:
+    static QImage renderShadow(BoxShadowRenderer::Backend backend, const QSize &boxSize, qreal borderRadius, int radius);
+};
+
+//* largest difference between the two backends, out of 255
+static const int s_maxError = 6;
+
+//* largest average difference between the two backends, out of 255
+static const qreal s_maxMeanError = 1.5;
+
+//________________________________________________________________
+QImage AnalyticBackendTest::renderShadow(BoxShadowRenderer::Backend backend, const QSize &boxSize, qreal borderRadius, int radius)
+{
+    BoxShadowRenderer renderer;
+    renderer.setBackend(backend);
+    renderer.setBoxSize(boxSize);
+    renderer.setBorderRadius(borderRadius);
+    renderer.addShadow(QPointF(0, 0), radius, Qt::black);
+    return renderer.render();
+}
+
+//________________________________________________________________
+void AnalyticBackendTest::matchesBoxBlur_data()
+{
+    QTest::addColumn<QSize>("boxSize");
+    QTest::addColumn<qreal>("borderRadius");
+    QTest::addColumn<int>("radius");
+
+    const QList<int> radii{8, 16, 32, 64, 128, 192};
+    const QList<qreal> borderRadii{0, 6, 20};
+
+    // Shadow users never make boxes smaller than calculateMinimumBoxSize(). Below
+    // that, the box blur of a quadrant clamps at the middle of the box and drifts
+    // away from a real gaussian, which the analytic backend keeps following.
+    for (int radius : radii) {
+        const QSize minimumBoxSize = BoxShadowRenderer::calculateMinimumBoxSize(radius);
+        const QList<QSize> boxSizes{minimumBoxSize, minimumBoxSize + QSize(136, 56)};
+
+        for (qreal borderRadius : borderRadii) {
+            for (const QSize &boxSize : boxSizes) {
+                QTest::addRow("%dx%d-c%d-r%d", boxSize.width(), boxSize.height(), int(borderRadius), radius) << boxSize << borderRadius << radius;
+            }
+        }
+    }
+}
+
+//________________________________________________________________
+void AnalyticBackendTest::matchesBoxBlur()
+{
+    QFETCH(QSize, boxSize);
+    QFETCH(qreal, borderRadius);
+    QFETCH(int, radius);
+
+    const QImage expected = renderShadow(BoxShadowRenderer::Backend::BoxBlur, boxSize, borderRadius, radius);
+    const QImage actual = renderShadow(BoxShadowRenderer::Backend::Analytic, boxSize, borderRadius, radius);
+
+    QVERIFY(!expected.isNull());
+    QCOMPARE(actual.size(), expected.size());
+
+    int maxError = 0;
+    qint64 totalError = 0;
+    for (int y = 0; y < expected.height(); ++y) {
+        const QRgb *expectedLine = reinterpret_cast<const QRgb *>(expected.constScanLine(y));
+        const QRgb *actualLine = reinterpret_cast<const QRgb *>(actual.constScanLine(y));
+        for (int x = 0; x < expected.width(); ++x) {
+            const int error = qAbs(qAlpha(actualLine[x]) - qAlpha(expectedLine[x]));
+            maxError = qMax(maxError, error);
+            totalError += error;
+        }
+    }
+
+    const qreal meanError = qreal(totalError) / (qint64(expected.width()) * expected.height());
+
+    QVERIFY2(maxError <= s_maxError, qPrintable(QStringLiteral("max error %1 exceeds %2").arg(maxError).arg(s_maxError)));
+    QVERIFY2(meanError <= s_maxMeanError, qPrintable(QStringLiteral("mean error %1 exceeds %2").arg(meanError).arg(s_maxMeanError)));
+}
+
+QTEST_GUILESS_MAIN(AnalyticBackendTest)
+
+#include "analyticbackendtest.moc"
@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "breezeboxshadowrenderer.h"
+
+#include <QTest>
+
+using namespace Breeze;
+
+Q_DECLARE_METATYPE(BoxShadowRenderer::BlurImplementation)
+
+class BoxBlurTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void cleanupTestCase();
+
+    void simdMatchesScalar_data();
+    void simdMatchesScalar();
+
+private:
+    static QImage renderShadow(BoxShadowRenderer::BlurImplementation implementation, const QSize &boxSize, int radius);
+};
+
+//________________________________________________________________
+QImage BoxBlurTest::renderShadow(BoxShadowRenderer::BlurImplementation implementation, const QSize &boxSize, int radius)
+{
+    // Forcing the implementation also drops the cached masks, so every call blurs again.
+    BoxShadowRenderer::setBlurImplementation(implementation);
+
+    BoxShadowRenderer renderer;
+    renderer.setBoxSize(boxSize);
+    renderer.setBorderRadius(3);
+    renderer.addShadow(QPointF(0, 0), radius, Qt::black);
+    return renderer.render();
+}
+
+//________________________________________________________________
+void BoxBlurTest::cleanupTestCase()
+{
+    BoxShadowRenderer::setBlurImplementation(BoxShadowRenderer::supportedBlurImplementations().constLast());
+}
+
+//________________________________________________________________
+void BoxBlurTest::simdMatchesScalar_data()
+{
+    QTest::addColumn<BoxShadowRenderer::BlurImplementation>("implementation");
+    QTest::addColumn<QSize>("boxSize");
+    QTest::addColumn<int>("radius");
+
+    const QVector<BoxShadowRenderer::BlurImplementation> implementations = BoxShadowRenderer::supportedBlurImplementations();
+    if (implementations.size() < 2) {
+        QSKIP("this CPU has no SIMD implementation of the box blur");
+    }
+
+    // Odd and even radii, and box sizes whose quadrants are not a multiple of
+    // the 16 lanes, so that the last block of every pass is only partially used.
+    const QList<int> radii{2, 3, 4, 7, 8, 13, 16, 17, 32, 33, 64, 65};
+    const QList<QSize> boxSizes{QSize(1, 1), QSize(5, 7), QSize(37, 21), QSize(64, 64), QSize(101, 61)};
+
+    for (BoxShadowRenderer::BlurImplementation implementation : implementations) {
+        if (implementation == BoxShadowRenderer::BlurImplementation::Scalar) {
+            continue;
+        }
+
+        for (int radius : radii) {
+            for (const QSize &boxSize : boxSizes) {
+                QTest::addRow("%d-%dx%d-r%d", int(implementation), boxSize.width(), boxSize.height(), radius) << implementation << boxSize << radius;
+            }
+        }
+    }
+}
+
+//________________________________________________________________
+void BoxBlurTest::simdMatchesScalar()
+{
+    QFETCH(BoxShadowRenderer::BlurImplementation, implementation);
+    QFETCH(QSize, boxSize);
+    QFETCH(int, radius);
+
+    const QImage expected = renderShadow(BoxShadowRenderer::BlurImplementation::Scalar, boxSize, radius);
+    const QImage actual = renderShadow(implementation, boxSize, radius);
+
+    QVERIFY(!expected.isNull());
+    QCOMPARE(actual.size(), expected.size());
+
+    for (int y = 0; y < expected.height(); ++y) {
+        const QRgb *expectedLine = reinterpret_cast<const QRgb *>(expected.constScanLine(y));
+        const QRgb *actualLine = reinterpret_cast<const QRgb *>(actual.constScanLine(y));
+        for (int x = 0; x < expected.width(); ++x) {
+            if (actualLine[x] != expectedLine[x]) {
+                QFAIL(qPrintable(QStringLiteral("pixel (%1, %2) differs: %3 instead of %4")
+                                     .arg(x)
+                                     .arg(y)
+                                     .arg(actualLine[x], 8, 16, QLatin1Char('0'))
+                                     .arg(expectedLine[x], 8, 16, QLatin1Char('0'))));
+            }
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(BoxBlurTest)
+
+#include "boxblurtest.moc"
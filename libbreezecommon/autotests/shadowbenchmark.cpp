@@ -0,0 +1,166 @@
+/*
+ * SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "shadowpresets.h"
+
+#include <QTest>
+
+using namespace Breeze;
+
+Q_DECLARE_METATYPE(BoxShadowRenderer::BlurImplementation)
+
+class ShadowBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void render_data();
+    void render();
+
+    void renderTiles_data();
+    void renderTiles();
+
+    void renderCached_data();
+    void renderCached();
+
+    void boxBlur_data();
+    void boxBlur();
+
+private:
+    static void addRows();
+};
+
+//________________________________________________________________
+void ShadowBenchmark::addRows()
+{
+    QTest::addColumn<CompositeShadowParams>("params");
+    QTest::addColumn<qreal>("cornerRadius");
+    QTest::addColumn<qreal>("dpr");
+
+    const QList<qreal> dprs{1.0, 1.25, 1.5, 2.0, 2.5, 3.0};
+    const QList<qreal> cornerRadii{DecorationCornerRadius, StyleCornerRadius};
+
+    for (const ShadowPreset &preset : shadowPresets()) {
+        for (qreal cornerRadius : cornerRadii) {
+            for (qreal dpr : dprs) {
+                QTest::addRow("%s-c%g@%gx", preset.name, cornerRadius, dpr) << preset.params << cornerRadius << dpr;
+            }
+        }
+    }
+}
+
+//________________________________________________________________
+void ShadowBenchmark::render_data()
+{
+    addRows();
+}
+
+//________________________________________________________________
+void ShadowBenchmark::render()
+{
+    QFETCH(CompositeShadowParams, params);
+    QFETCH(qreal, cornerRadius);
+    QFETCH(qreal, dpr);
+
+    BoxShadowRenderer renderer;
+    setupShadowRenderer(renderer, params, cornerRadius, dpr);
+
+    // Every shadow is rendered from scratch, as on the first use of a shadow size.
+    QBENCHMARK {
+        BoxShadowRenderer::clearCache();
+        const QImage shadow = renderer.render();
+        Q_UNUSED(shadow)
+    }
+}
+
+//________________________________________________________________
+void ShadowBenchmark::renderTiles_data()
+{
+    addRows();
+}
+
+//________________________________________________________________
+void ShadowBenchmark::renderTiles()
+{
+    QFETCH(CompositeShadowParams, params);
+    QFETCH(qreal, cornerRadius);
+    QFETCH(qreal, dpr);
+
+    BoxShadowRenderer renderer;
+    setupShadowRenderer(renderer, params, cornerRadius, dpr);
+
+    QBENCHMARK {
+        BoxShadowRenderer::clearCache();
+        const BoxShadowRenderer::Tiles tiles = renderer.renderTiles();
+        Q_UNUSED(tiles)
+    }
+}
+
+//________________________________________________________________
+void ShadowBenchmark::renderCached_data()
+{
+    addRows();
+}
+
+//________________________________________________________________
+void ShadowBenchmark::renderCached()
+{
+    QFETCH(CompositeShadowParams, params);
+    QFETCH(qreal, cornerRadius);
+    QFETCH(qreal, dpr);
+
+    BoxShadowRenderer renderer;
+    setupShadowRenderer(renderer, params, cornerRadius, dpr);
+    renderer.render();
+
+    // The masks are cached, as when only the color or the strength of a shadow changes.
+    QBENCHMARK {
+        const QImage shadow = renderer.render();
+        Q_UNUSED(shadow)
+    }
+}
+
+//________________________________________________________________
+void ShadowBenchmark::boxBlur_data()
+{
+    QTest::addColumn<BoxShadowRenderer::BlurImplementation>("implementation");
+    QTest::addColumn<int>("radius");
+
+    const QList<int> radii{16, 32, 48, 64, 96, 128, 192};
+    const QVector<BoxShadowRenderer::BlurImplementation> implementations = BoxShadowRenderer::supportedBlurImplementations();
+    const char *const names[] = {"scalar", "sse2", "avx2"};
+
+    for (int radius : radii) {
+        for (BoxShadowRenderer::BlurImplementation implementation : implementations) {
+            QTest::addRow("r%d-%s", radius, names[static_cast<int>(implementation)]) << implementation << radius;
+        }
+    }
+}
+
+//________________________________________________________________
+void ShadowBenchmark::boxBlur()
+{
+    QFETCH(BoxShadowRenderer::BlurImplementation, implementation);
+    QFETCH(int, radius);
+
+    // A single shadow, in a box as small as the shadow users make it, so the
+    // blur is most of the work. 192 is the largest shadow at a scale of 3.
+    BoxShadowRenderer renderer;
+    renderer.setBoxSize(BoxShadowRenderer::calculateMinimumBoxSize(radius));
+    renderer.addShadow(QPointF(0, 0), radius, Qt::black);
+
+    BoxShadowRenderer::setBlurImplementation(implementation);
+    QBENCHMARK {
+        BoxShadowRenderer::clearCache();
+        const QImage shadow = renderer.render();
+        Q_UNUSED(shadow)
+    }
+    BoxShadowRenderer::setBlurImplementation(BoxShadowRenderer::supportedBlurImplementations().constLast());
+}
+
+QTEST_GUILESS_MAIN(ShadowBenchmark)
+
+#include "shadowbenchmark.moc"
@@ -0,0 +1,86 @@
+/*
+ * SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include "breezeboxshadowrenderer.h"
+#include "breezeshadowparams.h"
+
+#include <QList>
+#include <QMetaType>
+
+namespace Breeze
+{
+/**
+ * A shadow as the window decoration or the widget style renders it.
+ *
+ * The params mirror s_shadowParams in kdecoration/breezedecoration.cpp and
+ * kstyle/breezeshadowhelper.cpp, keep them in sync.
+ **/
+struct ShadowPreset {
+    const char *name;
+    CompositeShadowParams params;
+
+    //* radius of the box' corners, in logical pixels
+    qreal cornerRadius;
+};
+
+//* corner radius of decorations, Frame_FrameRadius scaled by the small spacing plus half a pixel
+static constexpr qreal DecorationCornerRadius = 5.5;
+
+//* corner radius of the widget style, Frame_FrameRadius
+static constexpr qreal StyleCornerRadius = 5;
+
+//* every shadow size, except None
+inline QList<ShadowPreset> shadowPresets()
+{
+    return {
+        {"decoration-small", CompositeShadowParams(QPoint(0, 4), ShadowParams(QPoint(0, 0), 16, 1), ShadowParams(QPoint(0, -2), 8, 0.4)), DecorationCornerRadius},
+        {"decoration-medium", CompositeShadowParams(QPoint(0, 8), ShadowParams(QPoint(0, 0), 32, 0.9), ShadowParams(QPoint(0, -4), 16, 0.3)), DecorationCornerRadius},
+        {"decoration-large", CompositeShadowParams(QPoint(0, 12), ShadowParams(QPoint(0, 0), 48, 0.8), ShadowParams(QPoint(0, -6), 24, 0.2)), DecorationCornerRadius},
+        {"decoration-verylarge", CompositeShadowParams(QPoint(0, 16), ShadowParams(QPoint(0, 0), 64, 0.7), ShadowParams(QPoint(0, -8), 32, 0.1)), DecorationCornerRadius},
+        {"style-small", CompositeShadowParams(QPoint(0, 3), ShadowParams(QPoint(0, 0), 12, 0.26), ShadowParams(QPoint(0, -2), 6, 0.16)), StyleCornerRadius},
+        {"style-medium", CompositeShadowParams(QPoint(0, 4), ShadowParams(QPoint(0, 0), 16, 0.24), ShadowParams(QPoint(0, -2), 8, 0.14)), StyleCornerRadius},
+        {"style-large", CompositeShadowParams(QPoint(0, 5), ShadowParams(QPoint(0, 0), 20, 0.22), ShadowParams(QPoint(0, -3), 10, 0.12)), StyleCornerRadius},
+        {"style-verylarge", CompositeShadowParams(QPoint(0, 6), ShadowParams(QPoint(0, 0), 24, 0.2), ShadowParams(QPoint(0, -3), 12, 0.1)), StyleCornerRadius},
+    };
+}
+
+/**
+ * Set up a renderer the way the shadow users do.
+ *
+ * @param renderer The renderer, without any shadow yet.
+ * @param params The shadow params, in logical pixels.
+ * @param cornerRadius The radius of the box' corners, in logical pixels.
+ * @param dpr The device pixel ratio the geometry is scaled with.
+ **/
+inline void setupShadowRenderer(BoxShadowRenderer &renderer, CompositeShadowParams params, qreal cornerRadius, qreal dpr)
+{
+    params *= dpr;
+
+    const QSize boxSize =
+        BoxShadowRenderer::calculateMinimumBoxSize(params.shadow1.radius).expandedTo(BoxShadowRenderer::calculateMinimumBoxSize(params.shadow2.radius));
+
+    renderer.setBoxSize(boxSize);
+    renderer.setBorderRadius(cornerRadius * dpr);
+
+    QColor color1(Qt::black);
+    color1.setAlphaF(params.shadow1.opacity);
+    renderer.addShadow(params.shadow1.offset, params.shadow1.radius, color1);
+
+    QColor color2(Qt::black);
+    color2.setAlphaF(params.shadow2.opacity);
+    renderer.addShadow(params.shadow2.offset, params.shadow2.radius, color2);
+
+    // Mask out the window, which slightly overlaps the box.
+    QRect boxRect(QPoint(0, 0), boxSize);
+    boxRect.moveCenter(QRect(QPoint(0, 0), renderer.textureSize()).center());
+    renderer.setCutout(boxRect.adjusted(-2, -2, 2, 2).translated(-params.offset), cornerRadius * dpr);
+}
+
+} // namespace Breeze
+
+Q_DECLARE_METATYPE(Breeze::CompositeShadowParams)
@@ -0,0 +1,101 @@
+/*
+ * SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "shadowpresets.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTest>
+
+using namespace Breeze;
+
+/**
+ * Compare rendered shadows against stored references.
+ *
+ * Run with BREEZE_UPDATE_REFERENCES=1 to write the references instead, after
+ * an intended change of the rendered shadows. The references are meant to come
+ * from the renderer before any optimization, so they catch visual regressions.
+ **/
+class ShadowReferenceTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void matchesReference_data();
+    void matchesReference();
+};
+
+//* largest difference of a channel, out of 255, that is not a regression
+static const int s_tolerance = 2;
+
+//________________________________________________________________
+void ShadowReferenceTest::matchesReference_data()
+{
+    QTest::addColumn<CompositeShadowParams>("params");
+    QTest::addColumn<qreal>("cornerRadius");
+    QTest::addColumn<qreal>("dpr");
+    QTest::addColumn<QString>("fileName");
+
+    const QList<qreal> dprs{1.0, 1.5, 2.0};
+    for (const ShadowPreset &preset : shadowPresets()) {
+        for (qreal dpr : dprs) {
+            const QString fileName = QStringLiteral("%1@%2x.png").arg(QLatin1String(preset.name)).arg(dpr);
+            QTest::newRow(qPrintable(fileName)) << preset.params << preset.cornerRadius << dpr << fileName;
+        }
+    }
+}
+
+//________________________________________________________________
+void ShadowReferenceTest::matchesReference()
+{
+    QFETCH(CompositeShadowParams, params);
+    QFETCH(qreal, cornerRadius);
+    QFETCH(qreal, dpr);
+    QFETCH(QString, fileName);
+
+    BoxShadowRenderer renderer;
+    setupShadowRenderer(renderer, params, cornerRadius, dpr);
+    const QImage actual = renderer.render();
+    QVERIFY(!actual.isNull());
+
+    const QString path = QStringLiteral(SHADOW_REFERENCE_DIR "/") + fileName;
+    if (qEnvironmentVariableIsSet("BREEZE_UPDATE_REFERENCES")) {
+        QVERIFY(QDir().mkpath(QStringLiteral(SHADOW_REFERENCE_DIR)));
+        QVERIFY(actual.save(path));
+        return;
+    }
+
+    // a missing reference is a failure, a test that checks nothing must not pass
+    if (!QFile::exists(path)) {
+        QFAIL(qPrintable(QStringLiteral("no reference %1, run with BREEZE_UPDATE_REFERENCES=1 to create it").arg(path)));
+    }
+
+    const QImage expected = QImage(path).convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    QVERIFY(!expected.isNull());
+    QCOMPARE(actual.size(), expected.size());
+
+    for (int y = 0; y < expected.height(); ++y) {
+        const QRgb *expectedLine = reinterpret_cast<const QRgb *>(expected.constScanLine(y));
+        const QRgb *actualLine = reinterpret_cast<const QRgb *>(actual.constScanLine(y));
+        for (int x = 0; x < expected.width(); ++x) {
+            const QRgb a = actualLine[x];
+            const QRgb e = expectedLine[x];
+            const int error = qMax(qMax(qAbs(qRed(a) - qRed(e)), qAbs(qGreen(a) - qGreen(e))), qMax(qAbs(qBlue(a) - qBlue(e)), qAbs(qAlpha(a) - qAlpha(e))));
+            if (error > s_tolerance) {
+                QFAIL(qPrintable(QStringLiteral("pixel (%1, %2) differs by %3: %4 instead of %5")
+                                     .arg(x)
+                                     .arg(y)
+                                     .arg(error)
+                                     .arg(a, 8, 16, QLatin1Char('0'))
+                                     .arg(e, 8, 16, QLatin1Char('0'))));
+            }
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(ShadowReferenceTest)
+
+#include "shadowreferencetest.moc"
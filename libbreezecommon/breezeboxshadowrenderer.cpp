@@ -19,9 +19,32 @@
 #include "breezeboxshadowrenderer.h"
 
 // Qt
+#include <QAtomicInt>
+#include <QCache>
+#include <QDataStream>
+#include <QMutex>
 #include <QPainter>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
 #include <QtMath>
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BREEZE_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define BREEZE_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
 namespace Breeze
 {
 static inline int calculateBlurRadius(qreal stdDev)
@@ -91,196 +114,686 @@ static QVector<BoxLobes> computeLobes(int radius)
     return {{major, minor}, {minor, major}, {final, final}};
 }
 
+//* whether rendering may use more than one thread
+static std::atomic<bool> s_multithreaded{true};
+
+//* threads that help rendering shadows, next to the thread that renders them
+class RenderThreadPool : public QThreadPool
+{
+public:
+    RenderThreadPool()
+        : m_helperCount(qBound(0, QThread::idealThreadCount() - 1, 3))
+    {
+        setMaxThreadCount(qMax(1, m_helperCount));
+    }
+
+    //* number of helper threads, none on single core machines
+    int helperCount() const
+    {
+        return m_helperCount;
+    }
+
+private:
+    const int m_helperCount;
+};
+
 /**
- * Process a row with a box filter.
+ * A helper that takes ranges off a parallelFor() until none are left.
+ **/
+class ParallelTask : public QRunnable
+{
+public:
+    ParallelTask(const std::function<void(int)> &function, QAtomicInt &next, int count)
+        : m_function(function)
+        , m_next(next)
+        , m_count(count)
+    {
+        setAutoDelete(false);
+    }
+
+    void run() override
+    {
+        drain();
+        m_finished.release();
+    }
+
+    void drain()
+    {
+        for (int index = m_next.fetchAndAddRelaxed(1); index < m_count; index = m_next.fetchAndAddRelaxed(1)) {
+            m_function(index);
+        }
+    }
+
+    void wait()
+    {
+        m_finished.acquire();
+    }
+
+private:
+    const std::function<void(int)> &m_function;
+    QAtomicInt &m_next;
+    const int m_count;
+    QSemaphore m_finished;
+};
+
+/**
+ * Run a function over the range [0, count), split into contiguous batches.
  *
- * @param src The start of the row.
- * @param dst The destination.
- * @param width The width of the row, in pixels.
- * @param horizontalStride The number of bytes from one alpha value to the
- *    next alpha value.
- * @param verticalStride The number of bytes from one row to the next row.
- * @param lobes Params of the box filter.
- * @param transposeInput Whether the input is transposed.
- * @param transposeOutput Whether the output should be transposed.
+ * The calling thread works through the batches too, and batches that no
+ * helper picked up in the meantime are taken back from the pool. Thus nested
+ * calls never wait on a busy pool. Batches must be independent of each other,
+ * so that the result doesn't depend on the threads they ran on.
+ *
+ * @param count The size of the range.
+ * @param function Called with the begin and the end of every batch.
  **/
-static inline void boxBlurRowAlpha(const uint8_t *src,
-                                   uint8_t *dst,
-                                   int width,
-                                   int horizontalStride,
-                                   int verticalStride,
-                                   const BoxLobes &lobes,
-                                   bool transposeInput,
-                                   bool transposeOutput)
-{
-    const int inputStep = transposeInput ? verticalStride : horizontalStride;
-    const int outputStep = transposeOutput ? verticalStride : horizontalStride;
+static void parallelFor(int count, const std::function<void(int begin, int end)> &function)
+{
+    static RenderThreadPool pool;
 
-    const int boxSize = lobes.left + 1 + lobes.right;
-    const int reciprocal = (1 << 24) / boxSize;
+    const int helperCount = s_multithreaded ? qMin(count - 1, pool.helperCount()) : 0;
+    if (helperCount <= 0) {
+        if (count > 0) {
+            function(0, count);
+        }
+        return;
+    }
 
-    uint32_t alphaSum = (boxSize + 1) / 2;
+    const int batchCount = helperCount + 1;
+    const std::function<void(int)> runBatch = [&](int batch) {
+        function(batch * count / batchCount, (batch + 1) * count / batchCount);
+    };
 
-    const uint8_t *left = src;
-    const uint8_t *right = src;
-    uint8_t *out = dst;
+    QAtomicInt next(0);
+    std::vector<std::unique_ptr<ParallelTask>> helpers;
+    helpers.reserve(helperCount);
+    for (int i = 0; i < helperCount; ++i) {
+        helpers.emplace_back(new ParallelTask(runBatch, next, batchCount));
+        pool.start(helpers.back().get());
+    }
 
-    const uint8_t firstValue = src[0];
-    const uint8_t lastValue = src[(width - 1) * inputStep];
+    ParallelTask(runBatch, next, batchCount).drain();
 
-    alphaSum += firstValue * lobes.left;
+    for (const auto &helper : helpers) {
+        if (!pool.tryTake(helper.get())) {
+            helper->wait();
+        }
+    }
+}
+
+//* number of lines that are blurred at once
+static constexpr int BlurLanes = 16;
+
+//* smallest area, in pixels, that is worth blurring on several threads
+static constexpr int ParallelBlurArea = 128 * 128;
+
+/**
+ * Run a number of box filter steps on BlurLanes interleaved lines.
+ *
+ * For each step, the current sums are written out and then the value at @p add
+ * enters the window while the value at @p sub leaves it.
+ *
+ * @param sums The running sums, one per lane.
+ * @param out The destination of the first step.
+ * @param add The first value that enters the window.
+ * @param addStep The distance to the next entering value, either 0 or BlurLanes.
+ * @param sub The first value that leaves the window.
+ * @param subStep The distance to the next leaving value, either 0 or BlurLanes.
+ * @param count The number of steps.
+ * @param reciprocal The fixed point reciprocal of the box size.
+ **/
+using BlurStepsFunction = void (*)(uint32_t *sums, uint8_t *out, const uint8_t *add, int addStep, const uint8_t *sub, int subStep, int count, uint32_t reciprocal);
+
+static void blurStepsScalar(uint32_t *sums, uint8_t *out, const uint8_t *add, int addStep, const uint8_t *sub, int subStep, int count, uint32_t reciprocal)
+{
+    for (int i = 0; i < count; ++i) {
+        for (int lane = 0; lane < BlurLanes; ++lane) {
+            out[lane] = (sums[lane] * reciprocal) >> 24;
+            sums[lane] += uint32_t(add[lane]) - uint32_t(sub[lane]);
+        }
+        out += BlurLanes;
+        add += addStep;
+        sub += subStep;
+    }
+}
+
+#ifdef BREEZE_HAVE_SSE2
+static inline __m128i multiplyHigh24(__m128i sums, __m128i reciprocal)
+{
+    // SSE2 has no 32 bit multiplication, do it with two 64 bit ones and
+    // drop the upper halves to get the same wrap around as the scalar code.
+    const __m128i low32 = _mm_set_epi32(0, -1, 0, -1);
+    const __m128i even = _mm_srli_epi64(_mm_and_si128(_mm_mul_epu32(sums, reciprocal), low32), 24);
+    const __m128i odd = _mm_srli_epi64(_mm_and_si128(_mm_mul_epu32(_mm_srli_epi64(sums, 32), reciprocal), low32), 24);
+    return _mm_or_si128(even, _mm_slli_epi64(odd, 32));
+}
+
+static inline __m128i signExtend16To32(__m128i value, bool high)
+{
+    const __m128i doubled = high ? _mm_unpackhi_epi16(value, value) : _mm_unpacklo_epi16(value, value);
+    return _mm_srai_epi32(doubled, 16);
+}
+
+static void blurStepsSse2(uint32_t *sums, uint8_t *out, const uint8_t *add, int addStep, const uint8_t *sub, int subStep, int count, uint32_t reciprocal)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i factor = _mm_set1_epi32(reciprocal);
+
+    __m128i s0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(sums));
+    __m128i s1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(sums + 4));
+    __m128i s2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(sums + 8));
+    __m128i s3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(sums + 12));
 
-    const uint8_t *initEnd = src + (boxSize - lobes.left) * inputStep;
-    while (right < initEnd) {
-        alphaSum += *right;
-        right += inputStep;
+    for (int i = 0; i < count; ++i) {
+        // All results are below 256, so the saturating packs are lossless.
+        const __m128i low = _mm_packs_epi32(multiplyHigh24(s0, factor), multiplyHigh24(s1, factor));
+        const __m128i high = _mm_packs_epi32(multiplyHigh24(s2, factor), multiplyHigh24(s3, factor));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_packus_epi16(low, high));
+
+        const __m128i entering = _mm_loadu_si128(reinterpret_cast<const __m128i *>(add));
+        const __m128i leaving = _mm_loadu_si128(reinterpret_cast<const __m128i *>(sub));
+        const __m128i deltaLow = _mm_sub_epi16(_mm_unpacklo_epi8(entering, zero), _mm_unpacklo_epi8(leaving, zero));
+        const __m128i deltaHigh = _mm_sub_epi16(_mm_unpackhi_epi8(entering, zero), _mm_unpackhi_epi8(leaving, zero));
+        s0 = _mm_add_epi32(s0, signExtend16To32(deltaLow, false));
+        s1 = _mm_add_epi32(s1, signExtend16To32(deltaLow, true));
+        s2 = _mm_add_epi32(s2, signExtend16To32(deltaHigh, false));
+        s3 = _mm_add_epi32(s3, signExtend16To32(deltaHigh, true));
+
+        out += BlurLanes;
+        add += addStep;
+        sub += subStep;
     }
 
-    const uint8_t *leftEnd = src + boxSize * inputStep;
-    while (right < leftEnd) {
-        *out = (alphaSum * reciprocal) >> 24;
-        alphaSum += *right - firstValue;
-        right += inputStep;
-        out += outputStep;
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(sums), s0);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(sums + 4), s1);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(sums + 8), s2);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(sums + 12), s3);
+}
+#endif
+
+#ifdef BREEZE_HAVE_AVX2
+__attribute__((target("avx2"))) static void
+blurStepsAvx2(uint32_t *sums, uint8_t *out, const uint8_t *add, int addStep, const uint8_t *sub, int subStep, int count, uint32_t reciprocal)
+{
+    const __m256i factor = _mm256_set1_epi32(reciprocal);
+
+    __m256i s0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(sums));
+    __m256i s1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(sums + 8));
+
+    for (int i = 0; i < count; ++i) {
+        const __m256i r0 = _mm256_srli_epi32(_mm256_mullo_epi32(s0, factor), 24);
+        const __m256i r1 = _mm256_srli_epi32(_mm256_mullo_epi32(s1, factor), 24);
+        // packus works on 128 bit halves, put the lanes back in order afterwards.
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(r0, r1), 0xd8);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_packus_epi16(_mm256_castsi256_si128(packed), _mm256_extracti128_si256(packed, 1)));
+
+        const __m128i entering = _mm_loadu_si128(reinterpret_cast<const __m128i *>(add));
+        const __m128i leaving = _mm_loadu_si128(reinterpret_cast<const __m128i *>(sub));
+        s0 = _mm256_add_epi32(s0, _mm256_sub_epi32(_mm256_cvtepu8_epi32(entering), _mm256_cvtepu8_epi32(leaving)));
+        s1 = _mm256_add_epi32(s1, _mm256_sub_epi32(_mm256_cvtepu8_epi32(_mm_srli_si128(entering, 8)), _mm256_cvtepu8_epi32(_mm_srli_si128(leaving, 8))));
+
+        out += BlurLanes;
+        add += addStep;
+        sub += subStep;
     }
 
-    const uint8_t *centerEnd = src + width * inputStep;
-    while (right < centerEnd) {
-        *out = (alphaSum * reciprocal) >> 24;
-        alphaSum += *right - *left;
-        left += inputStep;
-        right += inputStep;
-        out += outputStep;
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(sums), s0);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(sums + 8), s1);
+}
+#endif
+
+static BlurStepsFunction blurStepsFunction(BoxShadowRenderer::BlurImplementation implementation)
+{
+    switch (implementation) {
+#ifdef BREEZE_HAVE_AVX2
+    case BoxShadowRenderer::BlurImplementation::Avx2:
+        return blurStepsAvx2;
+#endif
+#ifdef BREEZE_HAVE_SSE2
+    case BoxShadowRenderer::BlurImplementation::Sse2:
+        return blurStepsSse2;
+#endif
+    default:
+        return blurStepsScalar;
     }
+}
+
+//* blur steps used by boxBlurAlpha, the fastest supported ones unless forced otherwise
+static std::atomic<BlurStepsFunction> &currentBlurSteps()
+{
+    static std::atomic<BlurStepsFunction> function{blurStepsFunction(BoxShadowRenderer::supportedBlurImplementations().constLast())};
+    return function;
+}
+
+/**
+ * Process BlurLanes lines with a box filter.
+ *
+ * The lines are interleaved, i.e. the i-th value of a lane is stored at
+ * i * BlurLanes + lane, so that every step of the filter processes BlurLanes
+ * consecutive bytes at once.
+ *
+ * @param src The interleaved input lines.
+ * @param dst The interleaved output lines.
+ * @param length The length of the lines, in pixels.
+ * @param lobes Params of the box filter.
+ * @param blurSteps The implementation of the filter steps.
+ **/
+static void boxBlurLines(const uint8_t *src, uint8_t *dst, int length, const BoxLobes &lobes, BlurStepsFunction blurSteps)
+{
+    const int boxSize = lobes.left + 1 + lobes.right;
+    const uint32_t reciprocal = (1 << 24) / boxSize;
+    Q_ASSERT(length >= boxSize);
+
+    const uint8_t *first = src;
+    const uint8_t *last = src + (length - 1) * BlurLanes;
 
-    const uint8_t *rightEnd = dst + width * outputStep;
-    while (out < rightEnd) {
-        *out = (alphaSum * reciprocal) >> 24;
-        alphaSum += lastValue - *left;
-        left += inputStep;
-        out += outputStep;
+    uint32_t sums[BlurLanes];
+    for (int lane = 0; lane < BlurLanes; ++lane) {
+        sums[lane] = (boxSize + 1) / 2 + first[lane] * lobes.left;
     }
+    for (int i = 0; i <= lobes.right; ++i) {
+        for (int lane = 0; lane < BlurLanes; ++lane) {
+            sums[lane] += src[i * BlurLanes + lane];
+        }
+    }
+
+    // The window extends past the first value.
+    blurSteps(sums, dst, src + (lobes.right + 1) * BlurLanes, BlurLanes, first, 0, lobes.left, reciprocal);
+    dst += lobes.left * BlurLanes;
+
+    // The window is fully inside of the line.
+    blurSteps(sums, dst, src + boxSize * BlurLanes, BlurLanes, src, BlurLanes, length - boxSize, reciprocal);
+    dst += (length - boxSize) * BlurLanes;
+
+    // The window extends past the last value.
+    blurSteps(sums, dst, last, 0, src + (length - boxSize) * BlurLanes, BlurLanes, lobes.right + 1, reciprocal);
 }
 
 /**
- * Blur the alpha channel of a given image.
+ * Blur an alpha mask.
+ *
+ * Both passes work on blocks of BlurLanes rows or columns, which are copied
+ * into an interleaved buffer first. That turns the vertical pass into a
+ * sequence of small transposes instead of walking columns with a stride of
+ * a full scanline. Large masks have their blocks spread across threads.
  *
- * @param image The input image.
+ * @param mask The input mask, in Format_Alpha8.
  * @param radius The blur radius.
- * @param rect Specifies what part of the image to blur. If nothing is provided, then
- *    the whole alpha channel of the input image will be blurred.
+ * @param rect Specifies what part of the mask to blur. If nothing is provided, then
+ *    the whole mask will be blurred.
  **/
-static inline void boxBlurAlpha(QImage &image, int radius, const QRect &rect = {})
+static inline void boxBlurAlpha(QImage &mask, int radius, const QRect &rect = {})
 {
+    Q_ASSERT(mask.format() == QImage::Format_Alpha8);
+
     if (radius < 2) {
         return;
     }
 
     const QVector<BoxLobes> lobes = computeLobes(radius);
+    const BlurStepsFunction steps = currentBlurSteps().load(std::memory_order_relaxed);
 
-    const QRect blurRect = rect.isNull() ? image.rect() : rect;
+    const QRect blurRect = rect.isNull() ? mask.rect() : rect;
 
-    const int alphaOffset = QSysInfo::ByteOrder == QSysInfo::BigEndian ? 0 : 3;
     const int width = blurRect.width();
     const int height = blurRect.height();
-    const int rowStride = image.bytesPerLine();
-    const int pixelStride = image.depth() >> 3;
 
-    const int bufferStride = qMax(width, height) * pixelStride;
-    QScopedPointer<uint8_t, QScopedPointerArrayDeleter<uint8_t>> buf(new uint8_t[2 * bufferStride]);
-    uint8_t *buf1 = buf.data();
-    uint8_t *buf2 = buf1 + bufferStride;
+    // Don't let the worker threads detach the mask.
+    uint8_t *bits = mask.bits() + blurRect.y() * mask.bytesPerLine() + blurRect.x();
+    const qsizetype bytesPerLine = mask.bytesPerLine();
 
-    // Blur the image in horizontal direction.
-    for (int i = 0; i < height; ++i) {
-        uint8_t *row = image.scanLine(blurRect.y() + i) + blurRect.x() * pixelStride + alphaOffset;
-        boxBlurRowAlpha(row, buf1, width, pixelStride, rowStride, lobes[0], false, false);
-        boxBlurRowAlpha(buf1, buf2, width, pixelStride, rowStride, lobes[1], false, false);
-        boxBlurRowAlpha(buf2, row, width, pixelStride, rowStride, lobes[2], false, false);
-    }
+    // Blocks of lines are independent of each other, so they may be spread across threads.
+    auto blurBlocks = [&](int blockCount, const std::function<void(uint8_t *buf1, uint8_t *buf2, int block)> &blurBlock) {
+        const int bufferStride = qMax(width, height) * BlurLanes;
+        auto blurBatch = [&](int begin, int end) {
+            QScopedPointer<uint8_t, QScopedPointerArrayDeleter<uint8_t>> buf(new uint8_t[2 * bufferStride]());
+            for (int block = begin; block < end; ++block) {
+                blurBlock(buf.data(), buf.data() + bufferStride, block);
+            }
+        };
+
+        if (width * height >= ParallelBlurArea) {
+            parallelFor(blockCount, blurBatch);
+        } else {
+            blurBatch(0, blockCount);
+        }
+    };
+
+    // Blur the mask in horizontal direction.
+    blurBlocks((height + BlurLanes - 1) / BlurLanes, [&](uint8_t *buf1, uint8_t *buf2, int block) {
+        const int y = block * BlurLanes;
+        const int lanes = qMin(BlurLanes, height - y);
+
+        for (int lane = 0; lane < lanes; ++lane) {
+            const uint8_t *in = bits + (y + lane) * bytesPerLine;
+            for (int x = 0; x < width; ++x) {
+                buf1[x * BlurLanes + lane] = in[x];
+            }
+        }
 
-    // Blur the image in vertical direction.
-    for (int i = 0; i < width; ++i) {
-        uint8_t *column = image.scanLine(blurRect.y()) + (blurRect.x() + i) * pixelStride + alphaOffset;
-        boxBlurRowAlpha(column, buf1, height, pixelStride, rowStride, lobes[0], true, false);
-        boxBlurRowAlpha(buf1, buf2, height, pixelStride, rowStride, lobes[1], false, false);
-        boxBlurRowAlpha(buf2, column, height, pixelStride, rowStride, lobes[2], false, true);
+        boxBlurLines(buf1, buf2, width, lobes[0], steps);
+        boxBlurLines(buf2, buf1, width, lobes[1], steps);
+        boxBlurLines(buf1, buf2, width, lobes[2], steps);
+
+        for (int lane = 0; lane < lanes; ++lane) {
+            uint8_t *out = bits + (y + lane) * bytesPerLine;
+            for (int x = 0; x < width; ++x) {
+                out[x] = buf2[x * BlurLanes + lane];
+            }
+        }
+    });
+
+    // Blur the mask in vertical direction.
+    blurBlocks((width + BlurLanes - 1) / BlurLanes, [&](uint8_t *buf1, uint8_t *buf2, int block) {
+        const int x = block * BlurLanes;
+        const int lanes = qMin(BlurLanes, width - x);
+
+        for (int y = 0; y < height; ++y) {
+            memcpy(buf1 + y * BlurLanes, bits + y * bytesPerLine + x, lanes);
+        }
+
+        boxBlurLines(buf1, buf2, height, lobes[0], steps);
+        boxBlurLines(buf2, buf1, height, lobes[1], steps);
+        boxBlurLines(buf1, buf2, height, lobes[2], steps);
+
+        for (int y = 0; y < height; ++y) {
+            memcpy(bits + y * bytesPerLine + x, buf2 + y * BlurLanes, lanes);
+        }
+    });
+}
+
+static inline qreal gaussian(qreal x, qreal stdDev)
+{
+    return std::exp(-x * x / (2.0 * stdDev * stdDev)) / (stdDev * std::sqrt(2.0 * M_PI));
+}
+
+static inline qreal gaussianIntegral(qreal x, qreal stdDev)
+{
+    return 0.5 * (1.0 + std::erf(x / (stdDev * M_SQRT2)));
+}
+
+/**
+ * Compute the standard deviation of the gaussian that matches boxBlurAlpha.
+ *
+ * @param radius The blur radius.
+ **/
+static qreal calculateAnalyticStdDev(int radius)
+{
+    // The rasterizer samples the box by area, which is a box filter of its own.
+    qreal variance = 1.0 / 12.0;
+    if (radius >= 2) {
+        for (const BoxLobes &lobes : computeLobes(radius)) {
+            const int boxSize = lobes.left + 1 + lobes.right;
+            variance += (boxSize * boxSize - 1) / 12.0;
+        }
     }
+    return std::sqrt(variance);
 }
 
-static inline void mirrorTopLeftQuadrant(QImage &image)
+/**
+ * Evaluate the blurred rounded box directly, without rasterizing it.
+ *
+ * The blurred box is the product of two erf based integrals along its straight
+ * edges, minus the blurred area that is cut away by the rounded corner. The
+ * latter is tabulated as a sum of separable terms along the corner arc, so the
+ * cost depends on the number of pixels but not on the blur radius.
+ *
+ * Only the top-left quadrant is computed, the other corners are too far away
+ * to contribute to it.
+ *
+ * @param quadrant The top-left quadrant of the mask, in Format_Alpha8.
+ * @param box The box, in device pixels.
+ * @param cornerRadius The radius of the box' corners, in device pixels.
+ * @param stdDev The standard deviation of the gaussian, in device pixels.
+ **/
+static void renderAnalyticQuadrant(QImage &quadrant, const QRectF &box, qreal cornerRadius, qreal stdDev)
 {
-    const int width = image.width();
-    const int height = image.height();
+    Q_ASSERT(quadrant.format() == QImage::Format_Alpha8);
 
-    const int centerX = qCeil(width * 0.5);
-    const int centerY = qCeil(height * 0.5);
+    const int width = quadrant.width();
+    const int height = quadrant.height();
 
-    const int alphaOffset = QSysInfo::ByteOrder == QSysInfo::BigEndian ? 0 : 3;
-    const int stride = image.depth() >> 3;
+    QVector<qreal> columns(width);
+    for (int x = 0; x < width; ++x) {
+        columns[x] = gaussianIntegral(x + 0.5 - box.left(), stdDev) - gaussianIntegral(x + 0.5 - box.right(), stdDev);
+    }
+
+    QVector<qreal> rows(height);
+    for (int y = 0; y < height; ++y) {
+        rows[y] = gaussianIntegral(y + 0.5 - box.top(), stdDev) - gaussianIntegral(y + 0.5 - box.bottom(), stdDev);
+    }
 
-    for (int y = 0; y < centerY; ++y) {
-        uint8_t *in = image.scanLine(y) + alphaOffset;
-        uint8_t *out = in + (width - 1) * stride;
+    // Split the area outside of the corner arc into thin columns. The wider the
+    // gaussian, the fewer columns are needed to integrate it accurately.
+    const qreal radius = qMin(cornerRadius, qMin(box.width(), box.height()) * 0.5);
+    const int sampleCount = radius > 0 ? qBound(4, qCeil(radius * 4 / stdDev), qMax(4, qCeil(radius * 2))) : 0;
+    const qreal sampleWidth = sampleCount ? radius / sampleCount : 0;
 
-        for (int x = 0; x < centerX; ++x, in += stride, out -= stride) {
-            *out = *in;
+    QVector<qreal> cornerColumns(sampleCount * width);
+    QVector<qreal> cornerRows(sampleCount * height);
+    for (int sample = 0; sample < sampleCount; ++sample) {
+        const qreal distance = radius - (sample + 0.5) * sampleWidth;
+        const qreal depth = radius - std::sqrt(radius * radius - distance * distance);
+        const qreal center = box.left() + (sample + 0.5) * sampleWidth;
+
+        for (int x = 0; x < width; ++x) {
+            cornerColumns[sample * width + x] = sampleWidth * gaussian(x + 0.5 - center, stdDev);
+        }
+        for (int y = 0; y < height; ++y) {
+            cornerRows[sample * height + y] = gaussianIntegral(y + 0.5 - box.top(), stdDev) - gaussianIntegral(y + 0.5 - box.top() - depth, stdDev);
         }
     }
 
-    for (int y = 0; y < centerY; ++y) {
-        const uint8_t *in = image.scanLine(y) + alphaOffset;
-        uint8_t *out = image.scanLine(width - y - 1) + alphaOffset;
+    QVector<qreal> values(width);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            values[x] = columns[x] * rows[y];
+        }
+
+        for (int sample = 0; sample < sampleCount; ++sample) {
+            const qreal weight = cornerRows[sample * height + y];
+            if (weight < 1e-6) {
+                continue;
+            }
 
-        for (int x = 0; x < width; ++x, in += stride, out += stride) {
-            *out = *in;
+            const qreal *corner = cornerColumns.constData() + sample * width;
+            for (int x = 0; x < width; ++x) {
+                values[x] -= weight * corner[x];
+            }
+        }
+
+        uint8_t *out = quadrant.scanLine(y);
+        for (int x = 0; x < width; ++x) {
+            out[x] = qBound(0, qRound(values[x] * 255.0), 255);
         }
     }
 }
 
-static void renderShadow(QPainter *painter, const QRectF &rect, qreal borderRadius, const QPointF &offset, double radius, const QColor &color)
+/**
+ * Multiply all four channels of a premultiplied pixel by an alpha value.
+ **/
+static inline QRgb multiplyPixel(QRgb pixel, uint alpha)
+{
+    uint redBlue = (pixel & 0xff00ff) * alpha;
+    redBlue = ((redBlue + ((redBlue >> 8) & 0xff00ff) + 0x800080) >> 8) & 0xff00ff;
+
+    uint alphaGreen = ((pixel >> 8) & 0xff00ff) * alpha;
+    alphaGreen = (alphaGreen + ((alphaGreen >> 8) & 0xff00ff) + 0x800080) & 0xff00ff00;
+
+    return alphaGreen | redBlue;
+}
+
+/**
+ * The blurred mask of a single shadow.
+ *
+ * Because the mask is symmetrical, only its top-left quadrant is stored; the
+ * rest is mirrored when the mask gets composited.
+ **/
+struct BoxShadowRenderer::ShadowMask {
+    //* top-left quadrant of the mask, in Format_Alpha8
+    QImage quadrant;
+
+    //* size of the whole mask, in device pixels
+    QSize size;
+
+    //* position of the mask in the canvas, in device pixels
+    QPoint position;
+
+    //* color of the shadow
+    QColor color;
+};
+
+/**
+ * Calculate the size of a shadow mask.
+ *
+ * @param boxSize The size of the box.
+ * @param radius The blur radius.
+ * @param dpr The device pixel ratio.
+ **/
+static QSize calculateMaskSize(const QSizeF &boxSize, double radius, qreal dpr)
 {
-    const qreal dpr = painter->device()->devicePixelRatioF();
     const QSize inflation = calculateBlurExtent(radius);
-    const QSize pixelSize = ((rect.size() + 2 * inflation) * dpr).toSize();
-    const QSizeF size = QSizeF(pixelSize) / dpr;
+    return ((boxSize + 2 * inflation) * dpr).toSize();
+}
 
-    QImage shadow(pixelSize, QImage::Format_ARGB32_Premultiplied);
-    shadow.setDevicePixelRatio(dpr);
-    shadow.fill(Qt::transparent);
+/**
+ * Generate the top-left quadrant of a shadow mask.
+ *
+ * @param backend The algorithm used to generate the mask.
+ * @param boxSize The size of the box.
+ * @param borderRadius The radius of the box' corners.
+ * @param radius The blur radius.
+ * @param dpr The device pixel ratio.
+ **/
+static QImage renderMaskQuadrant(BoxShadowRenderer::Backend backend, const QSizeF &boxSize, qreal borderRadius, double radius, qreal dpr)
+{
+    const QSize pixelSize = calculateMaskSize(boxSize, radius, dpr);
+
+    QImage quadrant(std::ceil(pixelSize.width() * 0.5), std::ceil(pixelSize.height() * 0.5), QImage::Format_Alpha8);
+    quadrant.setDevicePixelRatio(dpr);
+    quadrant.fill(0);
 
-    QRectF boxRect(QPoint(0, 0), rect.size());
-    boxRect.moveCenter(QRectF(QPoint(0, 0), size).center());
+    QRectF boxRect(QPoint(0, 0), boxSize);
+    boxRect.moveCenter(QRectF(QPoint(0, 0), QSizeF(pixelSize) / dpr).center());
 
     const qreal xRadius = 2.0 * borderRadius / boxRect.width();
     const qreal yRadius = 2.0 * borderRadius / boxRect.height();
-
-    QPainter shadowPainter;
-    shadowPainter.begin(&shadow);
-    shadowPainter.setRenderHint(QPainter::Antialiasing);
-    shadowPainter.setPen(Qt::NoPen);
-    shadowPainter.setBrush(Qt::black);
-    shadowPainter.drawRoundedRect(boxRect, xRadius, yRadius);
-    shadowPainter.end();
-
-    // Because the shadow texture is symmetrical, that's enough to blur
-    // only the top-left quadrant and then mirror it.
-    const QRect blurRect(0, 0, std::ceil(shadow.width() * 0.5), std::ceil(shadow.height() * 0.5));
     const int scaledRadius = std::round(radius * dpr);
-    boxBlurAlpha(shadow, scaledRadius, blurRect);
-    mirrorTopLeftQuadrant(shadow);
 
-    // Give the shadow a tint of the desired color.
-    shadowPainter.begin(&shadow);
-    shadowPainter.setCompositionMode(QPainter::CompositionMode_SourceIn);
-    shadowPainter.fillRect(shadow.rect(), color);
-    shadowPainter.end();
+    switch (backend) {
+    case BoxShadowRenderer::Backend::BoxBlur: {
+        // Because the shadow texture is symmetrical, that's enough to rasterize
+        // and blur only the top-left quadrant.
+        QPainter maskPainter;
+        maskPainter.begin(&quadrant);
+        maskPainter.setRenderHint(QPainter::Antialiasing);
+        maskPainter.setPen(Qt::NoPen);
+        maskPainter.setBrush(Qt::black);
+        maskPainter.drawRoundedRect(boxRect, xRadius, yRadius);
+        maskPainter.end();
 
-    // Actually, present the shadow.
-    QRectF shadowRect = shadow.rect();
-    shadowRect.setSize(shadowRect.size() / dpr);
-    shadowRect.moveCenter(rect.center() + offset);
-    painter->drawImage(shadowRect, shadow);
+        boxBlurAlpha(quadrant, scaledRadius);
+        break;
+    }
+
+    case BoxShadowRenderer::Backend::Analytic: {
+        // drawRoundedRect() takes absolute radii, so match the box that the
+        // box blur backend rasterizes.
+        const QRectF scaledBoxRect(boxRect.topLeft() * dpr, boxRect.size() * dpr);
+        renderAnalyticQuadrant(quadrant, scaledBoxRect, qMin(xRadius, yRadius) * dpr, calculateAnalyticStdDev(scaledRadius));
+        break;
+    }
+    }
+
+    return quadrant;
+}
+
+/**
+ * Tint a shadow mask and composite it over a part of the canvas.
+ *
+ * This is the only step of the pipeline that touches 32 bit pixels.
+ *
+ * @param target The destination, in Format_ARGB32_Premultiplied.
+ * @param origin The position of the destination in the canvas, in device pixels.
+ * @param mask The shadow mask.
+ **/
+void BoxShadowRenderer::compositeMask(QImage &target, const QPoint &origin, const ShadowMask &mask)
+{
+    Q_ASSERT(target.format() == QImage::Format_ARGB32_Premultiplied);
+
+    const QRect area = QRect(mask.position, mask.size).intersected(QRect(origin, target.size()));
+    if (area.isEmpty()) {
+        return;
+    }
+
+    const QRgb tint = qPremultiply(mask.color.rgba());
+    if (qAlpha(tint) == 0) {
+        return;
+    }
+
+    const int quadrantWidth = mask.quadrant.width();
+    const int quadrantHeight = mask.quadrant.height();
+
+    for (int y = area.top(); y <= area.bottom(); ++y) {
+        const int maskY = y - mask.position.y();
+        const uint8_t *in = mask.quadrant.constScanLine(maskY < quadrantHeight ? maskY : mask.size.height() - maskY - 1);
+        QRgb *out = reinterpret_cast<QRgb *>(target.scanLine(y - origin.y())) - origin.x();
+
+        for (int x = area.left(); x <= area.right(); ++x) {
+            const int maskX = x - mask.position.x();
+            const uint8_t alpha = in[maskX < quadrantWidth ? maskX : mask.size.width() - maskX - 1];
+            if (!alpha) {
+                continue;
+            }
+
+            const QRgb source = multiplyPixel(tint, alpha);
+            out[x] = source + multiplyPixel(out[x], 255 - qAlpha(source));
+        }
+    }
+}
+
+/**
+ * Key of a cached shadow mask.
+ *
+ * Masks only depend on the geometry of a shadow. Its color is applied when the
+ * mask gets composited, so changing the color or the opacity never needs a blur.
+ **/
+struct MaskKey {
+    BoxShadowRenderer::Backend backend;
+    QSizeF boxSize;
+    qreal borderRadius;
+    double radius;
+    qreal dpr;
+
+    friend bool operator==(const MaskKey &lhs, const MaskKey &rhs)
+    {
+        return lhs.backend == rhs.backend && lhs.boxSize == rhs.boxSize && lhs.borderRadius == rhs.borderRadius && lhs.radius == rhs.radius
+            && lhs.dpr == rhs.dpr;
+    }
+
+    friend size_t qHash(const MaskKey &key, size_t seed = 0)
+    {
+        size_t hash = qHash(static_cast<int>(key.backend), seed);
+        hash = hash * 31 + qHash(key.boxSize.width());
+        hash = hash * 31 + qHash(key.boxSize.height());
+        hash = hash * 31 + qHash(key.borderRadius);
+        hash = hash * 31 + qHash(key.radius);
+        return hash * 31 + qHash(key.dpr);
+    }
+};
+
+//* shadow masks shared by all renderers, the cost is in kilobytes
+static QCache<MaskKey, QImage> &maskCache()
+{
+    static QCache<MaskKey, QImage> cache(8 * 1024);
+    return cache;
+}
+
+//* renderers may be used from any thread, so every access to maskCache() holds this
+static QMutex &maskCacheMutex()
+{
+    static QMutex mutex;
+    return mutex;
 }
 
 void BoxShadowRenderer::setBoxSize(const QSizeF &size)
@@ -293,6 +806,11 @@ void BoxShadowRenderer::setBorderRadius(qreal radius)
     m_borderRadius = radius;
 }
 
+void BoxShadowRenderer::setBackend(Backend backend)
+{
+    m_backend = backend;
+}
+
 void BoxShadowRenderer::addShadow(const QPointF &offset, double radius, const QColor &color)
 {
     Shadow shadow = {};
@@ -302,32 +820,198 @@ void BoxShadowRenderer::addShadow(const QPointF &offset, double radius, const QC
     m_shadows.append(shadow);
 }
 
-QImage BoxShadowRenderer::render() const
+void BoxShadowRenderer::setMultithreaded(bool multithreaded)
 {
-    if (m_shadows.isEmpty()) {
-        return {};
+    s_multithreaded = multithreaded;
+}
+
+QVector<BoxShadowRenderer::BlurImplementation> BoxShadowRenderer::supportedBlurImplementations()
+{
+    QVector<BlurImplementation> implementations{BlurImplementation::Scalar};
+#ifdef BREEZE_HAVE_SSE2
+    implementations.append(BlurImplementation::Sse2);
+#endif
+#ifdef BREEZE_HAVE_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        implementations.append(BlurImplementation::Avx2);
     }
+#endif
+    return implementations;
+}
+
+void BoxShadowRenderer::setBlurImplementation(BlurImplementation implementation)
+{
+    Q_ASSERT(supportedBlurImplementations().contains(implementation));
+    currentBlurSteps().store(blurStepsFunction(implementation), std::memory_order_relaxed);
+    clearCache();
+}
+
+void BoxShadowRenderer::clearCache()
+{
+    QMutexLocker locker(&maskCacheMutex());
+    maskCache().clear();
+}
 
+void BoxShadowRenderer::setCutout(const QRectF &rect, qreal radius)
+{
+    m_cutoutRect = rect;
+    m_cutoutRadius = radius;
+}
+
+QSize BoxShadowRenderer::textureSize() const
+{
     QSizeF canvasSize;
     for (const Shadow &shadow : std::as_const(m_shadows)) {
         canvasSize = canvasSize.expandedTo(calculateMinimumShadowTextureSize(m_boxSize, shadow.radius, shadow.offset));
     }
+    return canvasSize.toSize();
+}
 
-    QImage canvas(canvasSize.toSize(), QImage::Format_ARGB32_Premultiplied);
-    canvas.fill(Qt::transparent);
+//* bump whenever the rendered shadows change, it invalidates the shadows persisted by ShadowCache
+static const qint32 s_rendererRevision = 1;
+
+QByteArray BoxShadowRenderer::cacheKey() const
+{
+    QByteArray key;
+
+    QDataStream stream(&key, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_15);
+    stream << s_rendererRevision << static_cast<qint32>(m_backend) << m_boxSize << m_borderRadius << m_cutoutRect << m_cutoutRadius;
+    for (const Shadow &shadow : std::as_const(m_shadows)) {
+        stream << shadow.offset << shadow.radius << shadow.color;
+    }
+
+    return key;
+}
+
+void BoxShadowRenderer::applyCutout(QImage &target, const QPoint &origin) const
+{
+    if (m_cutoutRect.isEmpty() || !m_cutoutRect.intersects(QRectF(QRect(origin, target.size())))) {
+        return;
+    }
+
+    QPainter painter(&target);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(Qt::black);
+    painter.setCompositionMode(QPainter::CompositionMode_DestinationOut);
+    painter.translate(-origin);
+    painter.drawRoundedRect(m_cutoutRect, m_cutoutRadius, m_cutoutRadius);
+}
+
+QVector<BoxShadowRenderer::ShadowMask> BoxShadowRenderer::renderMasks(const QSize &canvasSize) const
+{
+    // The canvas is in device pixels, callers scale the geometry themselves.
+    const qreal dpr = 1.0;
 
     QRectF boxRect(QPoint(0, 0), m_boxSize);
-    boxRect.moveCenter(QRect(QPoint(0, 0), canvas.size()).center());
+    boxRect.moveCenter(QRect(QPoint(0, 0), canvasSize).center());
+
+    QVector<ShadowMask> masks;
+    masks.reserve(m_shadows.size());
 
-    QPainter painter(&canvas);
+    // Masks that are not cached yet get rendered concurrently, the cache is not
+    // locked meanwhile so that other renderers are not held up.
+    std::vector<int> missing;
+    QMutexLocker locker(&maskCacheMutex());
     for (const Shadow &shadow : std::as_const(m_shadows)) {
-        renderShadow(&painter, boxRect, m_borderRadius, shadow.offset, shadow.radius, shadow.color);
+        ShadowMask mask;
+        mask.size = calculateMaskSize(m_boxSize, shadow.radius, dpr);
+        mask.color = shadow.color;
+
+        const MaskKey key{m_backend, m_boxSize, m_borderRadius, shadow.radius, dpr};
+        if (const QImage *cached = maskCache().object(key)) {
+            mask.quadrant = *cached;
+        } else {
+            missing.push_back(masks.size());
+        }
+
+        QRectF shadowRect(QPointF(0, 0), QSizeF(mask.size) / dpr);
+        shadowRect.moveCenter(boxRect.center() + shadow.offset);
+        mask.position = QPoint(qRound(shadowRect.x() * dpr), qRound(shadowRect.y() * dpr));
+
+        masks.append(mask);
     }
-    painter.end();
+    locker.unlock();
+
+    std::vector<QImage> quadrants(missing.size());
+    parallelFor(static_cast<int>(missing.size()), [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            const Shadow &shadow = m_shadows.at(missing[i]);
+            quadrants[i] = renderMaskQuadrant(m_backend, m_boxSize, m_borderRadius, shadow.radius, dpr);
+        }
+    });
+
+    locker.relock();
+    for (size_t i = 0; i < missing.size(); ++i) {
+        const Shadow &shadow = m_shadows.at(missing[i]);
+        const MaskKey key{m_backend, m_boxSize, m_borderRadius, shadow.radius, dpr};
+        masks[missing[i]].quadrant = quadrants[i];
+        maskCache().insert(key, new QImage(quadrants[i]), qMax<qsizetype>(1, quadrants[i].sizeInBytes() / 1024));
+    }
+
+    return masks;
+}
+
+QImage BoxShadowRenderer::render() const
+{
+    if (m_shadows.isEmpty()) {
+        return {};
+    }
+
+    QImage canvas(textureSize(), QImage::Format_ARGB32_Premultiplied);
+    canvas.fill(Qt::transparent);
+
+    const QVector<ShadowMask> masks = renderMasks(canvas.size());
+    for (const ShadowMask &mask : masks) {
+        compositeMask(canvas, QPoint(0, 0), mask);
+    }
+    applyCutout(canvas, QPoint(0, 0));
 
     return canvas;
 }
 
+BoxShadowRenderer::Tiles BoxShadowRenderer::renderTiles() const
+{
+    Tiles tiles;
+    if (m_shadows.isEmpty()) {
+        return tiles;
+    }
+
+    tiles.size = textureSize();
+
+    const QVector<ShadowMask> masks = renderMasks(tiles.size);
+    for (int i = 0; i < Tiles::TileCount; ++i) {
+        const QRect rect = tiles.rect(static_cast<Tiles::Tile>(i));
+        if (rect.isEmpty()) {
+            continue;
+        }
+
+        QImage &tile = tiles.tiles[i];
+        tile = QImage(rect.size(), QImage::Format_ARGB32_Premultiplied);
+        tile.fill(Qt::transparent);
+
+        for (const ShadowMask &mask : masks) {
+            compositeMask(tile, rect.topLeft(), mask);
+        }
+        applyCutout(tile, rect.topLeft());
+    }
+
+    return tiles;
+}
+
+QRect BoxShadowRenderer::Tiles::rect(Tile tile) const
+{
+    const QPoint center = QRect(QPoint(0, 0), size).center();
+
+    const int columns[] = {0, center.x(), center.x() + 1, size.width()};
+    const int rows[] = {0, center.y(), center.y() + 1, size.height()};
+
+    const int column = tile % 3;
+    const int row = tile / 3;
+    return QRect(QPoint(columns[column], rows[row]), QPoint(columns[column + 1] - 1, rows[row + 1] - 1));
+}
+
 QSize BoxShadowRenderer::calculateMinimumBoxSize(int radius)
 {
     const QSize blurExtent = calculateBlurExtent(radius);
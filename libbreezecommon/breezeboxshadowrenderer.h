@@ -12,6 +12,8 @@
 #include <QPoint>
 #include <QSize>
 
+#include <array>
+
 namespace Breeze
 {
 class BoxShadowRenderer
@@ -19,6 +21,61 @@ class BoxShadowRenderer
 public:
     // Compiler generated constructors & destructor are fine.
 
+    /**
+     * The algorithm that is used to generate the shadows.
+     **/
+    enum class Backend {
+        //* Rasterize the box and approximate a gaussian blur with three box blurs.
+        BoxBlur,
+        //* Evaluate the gaussian blur of the box per pixel, at a cost that does not depend on the radius.
+        Analytic,
+    };
+
+    /**
+     * Set the algorithm that is used to generate the shadows.
+     * @param backend The backend, BoxBlur by default.
+     **/
+    void setBackend(Backend backend);
+
+    /**
+     * Allow rendering shadows on several threads.
+     *
+     * Shadows are bit-identical either way, rendering on a single thread is
+     * meant for testing and debugging.
+     * @param multithreaded Whether threads are used, true by default.
+     **/
+    static void setMultithreaded(bool multithreaded);
+
+    /**
+     * The instruction sets that the box blur can use.
+     **/
+    enum class BlurImplementation {
+        Scalar,
+        Sse2,
+        Avx2,
+    };
+
+    /**
+     * List the box blur implementations that this CPU supports.
+     **/
+    static QVector<BlurImplementation> supportedBlurImplementations();
+
+    /**
+     * Force the box blur to use a given implementation.
+     *
+     * All implementations produce bit-identical shadows, forcing one is meant
+     * for testing. Cached shadow masks are dropped.
+     * @param implementation The implementation, which must be supported.
+     **/
+    static void setBlurImplementation(BlurImplementation implementation);
+
+    /**
+     * Drop the shadow masks that are shared by all renderers.
+     *
+     * The next render blurs every mask again, which is meant for benchmarks.
+     **/
+    static void clearCache();
+
     /**
      * Set the size of the box.
      * @param size The size of the box.
@@ -39,11 +96,79 @@ public:
      **/
     void addShadow(const QPointF &offset, double radius, const QColor &color);
 
+    /**
+     * Cut a rounded rectangle out of the rendered shadow.
+     *
+     * This is usually the area covered by the window, which never shows the shadow.
+     * @param rect The rectangle to clear, in texture coordinates.
+     * @param radius The radius of its corners.
+     **/
+    void setCutout(const QRectF &rect, qreal radius);
+
+    /**
+     * Calculate the size of the rendered shadow texture.
+     **/
+    QSize textureSize() const;
+
+    /**
+     * A key that identifies the rendered shadow.
+     *
+     * Renderers with equal keys render identical shadows, which makes the key
+     * suitable to share rendered shadows across users. The key includes the
+     * revision of the renderer, so it stays valid across versions.
+     **/
+    QByteArray cacheKey() const;
+
+    /**
+     * Nine-patch of a shadow texture.
+     *
+     * The texture is split at its center into four corners, four 1 pixel wide
+     * edges and a 1x1 center tile.
+     **/
+    struct Tiles {
+        enum Tile {
+            TopLeft,
+            Top,
+            TopRight,
+            Left,
+            Center,
+            Right,
+            BottomLeft,
+            Bottom,
+            BottomRight,
+            TileCount,
+        };
+
+        //* size of the whole shadow texture
+        QSize size;
+
+        //* tile images, in the order of the Tile enum
+        std::array<QImage, TileCount> tiles;
+
+        //* geometry of the given tile in the shadow texture
+        QRect rect(Tile tile) const;
+
+        bool isNull() const
+        {
+            return size.isEmpty();
+        }
+    };
+
     /**
      * Render the shadow.
+     *
+     * The blurred masks are cached by geometry, so rendering the same shadows
+     * again with only different colors just recolors them.
      **/
     QImage render() const;
 
+    /**
+     * Render the shadow as a nine-patch.
+     *
+     * Only the tiles are rendered, the whole shadow texture is never allocated.
+     **/
+    Tiles renderTiles() const;
+
     /**
      * Calculate the minimum size of the box.
      *
@@ -67,8 +192,17 @@ public:
     static QSizeF calculateMinimumShadowTextureSize(const QSizeF &boxSize, double radius, const QPointF &offset);
 
 private:
+    struct ShadowMask;
+
+    QVector<ShadowMask> renderMasks(const QSize &canvasSize) const;
+    static void compositeMask(QImage &target, const QPoint &origin, const ShadowMask &mask);
+    void applyCutout(QImage &target, const QPoint &origin) const;
+
     QSizeF m_boxSize;
     qreal m_borderRadius = 0.0;
+    Backend m_backend = Backend::BoxBlur;
+    QRectF m_cutoutRect;
+    qreal m_cutoutRadius = 0.0;
 
     struct Shadow {
         QPointF offset;
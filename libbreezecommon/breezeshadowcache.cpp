@@ -0,0 +1,418 @@
+/*
+ * SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+// own
+#include "breezeshadowcache.h"
+#include "breezecommon_logging.h"
+
+// Qt
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThreadPool>
+
+#include <cstring>
+#include <limits>
+#include <memory>
+
+namespace Breeze
+{
+//* default byte budget, enough for a handful of scales of every shadow size
+static const qint64 s_defaultMaxBytes = 32 * 1024 * 1024;
+
+//* QCache costs are plain ints with Qt 5
+static int clampedCost(qint64 bytes)
+{
+    return static_cast<int>(qBound<qint64>(1, bytes, std::numeric_limits<int>::max()));
+}
+
+/**
+ * Layout of a shadow cache file.
+ *
+ * The file starts with a FileHeader followed by the full cache key, which
+ * guards against hash collisions, and one ImageHeader per image. The pixels of
+ * every image follow at 16 byte aligned offsets, so they can be used in place
+ * once the file is mapped. Files are written in native byte order; a file from
+ * a machine with a different one fails the magic check and is rendered again.
+ **/
+static const quint32 s_fileMagic = 0x42535343; // "BSSC"
+
+//* bump whenever the layout of cache files changes
+static const quint32 s_fileVersion = 1;
+
+/**
+ * Files kept on disk, the least recently written ones are removed first.
+ *
+ * Decorations render 16 shadows along their activation animation, so this
+ * fits that ladder for every shadow size at a few scales, next to the shadows
+ * of the widget style.
+ **/
+static const int s_maxFiles = 512;
+
+//* once there are too many files, the oldest ones are removed down to this count
+static const int s_pruneTarget = s_maxFiles * 3 / 4;
+
+struct FileHeader {
+    quint32 magic;
+    quint32 version;
+    quint32 keySize;
+    quint32 imageCount;
+    qint32 width;
+    qint32 height;
+};
+
+struct ImageHeader {
+    qint32 width;
+    qint32 height;
+    qint32 bytesPerLine;
+    qint32 format;
+    qint64 offset;
+};
+
+static qint64 alignedOffset(qint64 offset)
+{
+    return (offset + 15) & ~qint64(15);
+}
+
+static QString cacheDirectory()
+{
+    const QString location = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+    if (location.isEmpty()) {
+        return QString();
+    }
+    return location + QStringLiteral("/breeze/shadows");
+}
+
+static QString cacheFileName(const QString &directory, const QByteArray &key)
+{
+    return directory + QLatin1Char('/') + QString::fromLatin1(QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex());
+}
+
+//* keeps the file mapped while images use its pixels
+static void releaseMapping(void *info)
+{
+    delete static_cast<std::shared_ptr<QFile> *>(info);
+}
+
+/**
+ * Map the images stored for the key.
+ *
+ * The returned images use the mapped pixels directly and are read-only.
+ * @return whether the file exists and is valid.
+ **/
+static bool loadImages(const QByteArray &key, QSize &size, QVector<QImage> &images)
+{
+    const QString directory = cacheDirectory();
+    if (directory.isEmpty()) {
+        return false;
+    }
+
+    auto file = std::make_shared<QFile>(cacheFileName(directory, key));
+    if (!file->open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const qint64 fileSize = file->size();
+    if (fileSize < qint64(sizeof(FileHeader))) {
+        return false;
+    }
+
+    const uchar *data = file->map(0, fileSize);
+    if (!data) {
+        return false;
+    }
+
+    FileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != s_fileMagic || header.version != s_fileVersion || header.keySize != quint32(key.size())
+        || header.imageCount > BoxShadowRenderer::Tiles::TileCount) {
+        return false;
+    }
+
+    qint64 offset = sizeof(FileHeader);
+    if (offset + header.keySize + header.imageCount * sizeof(ImageHeader) > quint64(fileSize)) {
+        return false;
+    }
+
+    if (std::memcmp(data + offset, key.constData(), key.size()) != 0) {
+        return false;
+    }
+    offset += header.keySize;
+
+    QVector<QImage> mapped;
+    mapped.reserve(header.imageCount);
+    for (quint32 i = 0; i < header.imageCount; ++i, offset += sizeof(ImageHeader)) {
+        ImageHeader imageHeader;
+        std::memcpy(&imageHeader, data + offset, sizeof(imageHeader));
+
+        if (imageHeader.width == 0 || imageHeader.height == 0) {
+            mapped.append(QImage());
+            continue;
+        }
+
+        // The header comes from disk and may be corrupt, so nothing may overflow
+        // before the pixels are known to be inside of the file.
+        const qint64 width = imageHeader.width;
+        const qint64 height = imageHeader.height;
+        const qint64 bytesPerLine = imageHeader.bytesPerLine;
+        if (imageHeader.format != QImage::Format_ARGB32_Premultiplied || width < 0 || height < 0 || bytesPerLine < width * 4 || bytesPerLine % 4 != 0
+            || imageHeader.offset < 0 || imageHeader.offset % 16 != 0 || imageHeader.offset > fileSize
+            || bytesPerLine * height > fileSize - imageHeader.offset) {
+            return false;
+        }
+
+        mapped.append(QImage(data + imageHeader.offset,
+                             imageHeader.width,
+                             imageHeader.height,
+                             imageHeader.bytesPerLine,
+                             QImage::Format_ARGB32_Premultiplied,
+                             releaseMapping,
+                             new std::shared_ptr<QFile>(file)));
+    }
+
+    size = QSize(header.width, header.height);
+    images = mapped;
+    return true;
+}
+
+//* files in the cache directory as far as this process knows, -1 until they are counted
+static int s_fileCount = -1;
+
+/**
+ * Account for a new file, and remove the oldest files once there are too many.
+ *
+ * The directory is only listed to count the files once, and when the count
+ * exceeds the limit. Other processes write to the directory too, so the count
+ * is an estimate that is corrected whenever the directory gets listed.
+ **/
+static void pruneCacheDirectory(const QString &directory)
+{
+    if (s_fileCount >= 0 && ++s_fileCount <= s_maxFiles) {
+        return;
+    }
+
+    const QFileInfoList entries = QDir(directory).entryInfoList(QDir::Files, QDir::Time);
+    s_fileCount = entries.size();
+    if (s_fileCount <= s_maxFiles) {
+        return;
+    }
+
+    for (int i = s_pruneTarget; i < entries.size(); ++i) {
+        QFile::remove(entries.at(i).absoluteFilePath());
+    }
+    s_fileCount = s_pruneTarget;
+}
+
+/**
+ * Store the images for the key.
+ *
+ * The file is written atomically, so concurrent readers never see partial
+ * files. This runs on the writer thread only, see saveImagesLater().
+ **/
+static void saveImages(const QByteArray &key, const QSize &size, const QVector<QImage> &images)
+{
+    const QString directory = cacheDirectory();
+    if (directory.isEmpty() || !QDir().mkpath(directory)) {
+        return;
+    }
+
+    FileHeader header;
+    header.magic = s_fileMagic;
+    header.version = s_fileVersion;
+    header.keySize = key.size();
+    header.imageCount = images.size();
+    header.width = size.width();
+    header.height = size.height();
+
+    QVector<ImageHeader> imageHeaders;
+    imageHeaders.reserve(images.size());
+
+    qint64 offset = alignedOffset(sizeof(FileHeader) + key.size() + images.size() * sizeof(ImageHeader));
+    for (const QImage &image : images) {
+        Q_ASSERT(image.isNull() || image.format() == QImage::Format_ARGB32_Premultiplied);
+
+        ImageHeader imageHeader = {};
+        if (!image.isNull()) {
+            imageHeader.width = image.width();
+            imageHeader.height = image.height();
+            imageHeader.bytesPerLine = image.bytesPerLine();
+            imageHeader.format = image.format();
+            imageHeader.offset = offset;
+            offset = alignedOffset(offset + image.sizeInBytes());
+        }
+        imageHeaders.append(imageHeader);
+    }
+
+    QSaveFile file(cacheFileName(directory, key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(key);
+    file.write(reinterpret_cast<const char *>(imageHeaders.constData()), imageHeaders.size() * sizeof(ImageHeader));
+
+    for (int i = 0; i < images.size(); ++i) {
+        if (images.at(i).isNull()) {
+            continue;
+        }
+
+        // Pad up to the aligned offset of the image.
+        file.write(QByteArray(static_cast<int>(imageHeaders.at(i).offset - file.pos()), '\0'));
+        file.write(reinterpret_cast<const char *>(images.at(i).constBits()), images.at(i).sizeInBytes());
+    }
+
+    if (file.commit()) {
+        pruneCacheDirectory(directory);
+    }
+}
+
+//* a single thread that writes cache files, in the order they were rendered
+class WriterThreadPool : public QThreadPool
+{
+public:
+    WriterThreadPool()
+    {
+        setMaxThreadCount(1);
+    }
+};
+
+/**
+ * Store the images for the key in the background.
+ *
+ * Writing and syncing a file takes far longer than rendering a shadow, so it
+ * never happens on the thread that rendered it. Having a single writer thread
+ * also serializes pruneCacheDirectory(). Pending files are still written when
+ * the process exits.
+ **/
+static void saveImagesLater(const QByteArray &key, const QSize &size, const QVector<QImage> &images)
+{
+    static WriterThreadPool pool;
+
+    pool.start([key, size, images] {
+        saveImages(key, size, images);
+    });
+}
+
+ShadowCache &ShadowCache::self()
+{
+    static ShadowCache cache;
+    return cache;
+}
+
+ShadowCache::ShadowCache()
+    : m_entries(clampedCost(s_defaultMaxBytes))
+{
+}
+
+ShadowCache::Entry *ShadowCache::find(const QByteArray &key)
+{
+    Entry *entry = m_entries.object(key);
+    if (entry) {
+        ++m_hits;
+    } else {
+        ++m_misses;
+    }
+    return entry;
+}
+
+QImage ShadowCache::render(const BoxShadowRenderer &renderer)
+{
+    const QByteArray key = QByteArrayLiteral("texture:") + renderer.cacheKey();
+    if (const Entry *entry = find(key)) {
+        return entry->image;
+    }
+
+    QImage image;
+
+    QSize size;
+    QVector<QImage> images;
+    if (m_persistent && loadImages(key, size, images) && images.size() == 1) {
+        ++m_diskHits;
+        image = images.first();
+    } else {
+        image = renderer.render();
+        if (m_persistent && !image.isNull()) {
+            saveImagesLater(key, image.size(), {image});
+        }
+    }
+
+    if (!image.isNull()) {
+        m_entries.insert(key, new Entry{image, {}}, clampedCost(image.sizeInBytes()));
+    }
+    logStatistics();
+    return image;
+}
+
+BoxShadowRenderer::Tiles ShadowCache::renderTiles(const BoxShadowRenderer &renderer)
+{
+    const QByteArray key = QByteArrayLiteral("tiles:") + renderer.cacheKey();
+    if (const Entry *entry = find(key)) {
+        return entry->tiles;
+    }
+
+    BoxShadowRenderer::Tiles tiles;
+
+    QSize size;
+    QVector<QImage> images;
+    if (m_persistent && loadImages(key, size, images) && images.size() == BoxShadowRenderer::Tiles::TileCount) {
+        ++m_diskHits;
+        tiles.size = size;
+        std::copy(images.cbegin(), images.cend(), tiles.tiles.begin());
+    } else {
+        tiles = renderer.renderTiles();
+        if (m_persistent && !tiles.isNull()) {
+            saveImagesLater(key, tiles.size, QVector<QImage>(tiles.tiles.cbegin(), tiles.tiles.cend()));
+        }
+    }
+
+    if (!tiles.isNull()) {
+        qint64 bytes = 0;
+        for (const QImage &tile : tiles.tiles) {
+            bytes += tile.sizeInBytes();
+        }
+        m_entries.insert(key, new Entry{{}, tiles}, clampedCost(bytes));
+    }
+    logStatistics();
+    return tiles;
+}
+
+void ShadowCache::setMaxBytes(qint64 bytes)
+{
+    if (bytes == maxBytes()) {
+        return;
+    }
+
+    m_entries.setMaxCost(clampedCost(bytes));
+    logStatistics();
+}
+
+ShadowCache::Statistics ShadowCache::statistics() const
+{
+    Statistics statistics;
+    statistics.hits = m_hits;
+    statistics.misses = m_misses;
+    statistics.diskHits = m_diskHits;
+    statistics.bytes = m_entries.totalCost();
+    statistics.count = m_entries.count();
+    return statistics;
+}
+
+void ShadowCache::logStatistics() const
+{
+    const Statistics statistics = this->statistics();
+    qCDebug(BREEZE_SHADOWCACHE) << "hits:" << statistics.hits << "misses:" << statistics.misses << "loaded from disk:" << statistics.diskHits
+                                << "textures:" << statistics.count << "bytes:" << statistics.bytes << "of" << maxBytes();
+}
+
+void ShadowCache::clear()
+{
+    m_entries.clear();
+}
+
+} // namespace Breeze
@@ -0,0 +1,117 @@
+/*
+ * SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+#include "breezeboxshadowrenderer.h"
+
+// Qt
+#include <QByteArray>
+#include <QCache>
+
+namespace Breeze
+{
+/**
+ * Cache of rendered shadow textures.
+ *
+ * Textures are keyed by everything their renderer depends on, i.e. the shadow
+ * params, the corner radius and the device pixel ratio the geometry was scaled
+ * with, and the color. The least recently used textures are evicted once the
+ * cache exceeds its byte budget.
+ *
+ * Rendered textures are also persisted in the breeze/shadows directory under
+ * XDG_CACHE_HOME, so other processes, and later runs, map them instead of
+ * rendering them again.
+ *
+ * The cache is meant to be used from the GUI thread only. Its statistics are
+ * logged to the breeze.shadowcache category whenever a texture is rendered or
+ * loaded, or the budget changes.
+ **/
+class ShadowCache
+{
+public:
+    //* cache usage, for debugging
+    struct Statistics {
+        quint64 hits = 0;
+        quint64 misses = 0;
+        //* memory misses that were loaded from disk
+        quint64 diskHits = 0;
+        qint64 bytes = 0;
+        int count = 0;
+    };
+
+    //* the cache shared by all shadow users
+    static ShadowCache &self();
+
+    /**
+     * Render a shadow texture, or return the cached one.
+     * @param renderer The configured renderer.
+     **/
+    QImage render(const BoxShadowRenderer &renderer);
+
+    /**
+     * Render a shadow nine-patch, or return the cached one.
+     * @param renderer The configured renderer.
+     **/
+    BoxShadowRenderer::Tiles renderTiles(const BoxShadowRenderer &renderer);
+
+    /**
+     * Set the byte budget, evicting textures if needed.
+     *
+     * Shadow users set it from the ShadowCacheSize entry of breezerc.
+     * @param bytes The budget, 32 MiB by default.
+     **/
+    void setMaxBytes(qint64 bytes);
+
+    qint64 maxBytes() const
+    {
+        return m_entries.maxCost();
+    }
+
+    /**
+     * Enable or disable the on-disk cache.
+     * @param persistent Whether textures are looked up on and written to disk, true by default.
+     **/
+    void setPersistent(bool persistent)
+    {
+        m_persistent = persistent;
+    }
+
+    bool isPersistent() const
+    {
+        return m_persistent;
+    }
+
+    Statistics statistics() const;
+
+    //* drop all cached textures
+    void clear();
+
+private:
+    ShadowCache();
+
+    struct Entry {
+        QImage image;
+        BoxShadowRenderer::Tiles tiles;
+    };
+
+    //* cached entry for the key, counting hits and misses
+    Entry *find(const QByteArray &key);
+
+    //* log the statistics to the debug category
+    void logStatistics() const;
+
+    //* entries, the cost is in bytes
+    QCache<QByteArray, Entry> m_entries;
+
+    quint64 m_hits = 0;
+    quint64 m_misses = 0;
+    quint64 m_diskHits = 0;
+
+    bool m_persistent = true;
+};
+
+} // namespace Breeze
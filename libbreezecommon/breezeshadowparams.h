@@ -0,0 +1,64 @@
+/*
+ * SPDX-FileCopyrightText: 2014 Hugo Pereira Da Costa <hugo.pereira@free.fr>
+ * SPDX-FileCopyrightText: 2020 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#pragma once
+
+// Qt
+#include <QPoint>
+#include <QtGlobal>
+
+namespace Breeze
+{
+struct ShadowParams {
+    ShadowParams() = default;
+
+    ShadowParams(const QPoint &offset, int radius, qreal opacity)
+        : offset(offset)
+        , radius(radius)
+        , opacity(opacity)
+    {
+    }
+
+    QPoint offset;
+    int radius = 0;
+    qreal opacity = 0;
+
+    void operator*=(qreal factor)
+    {
+        offset *= factor;
+        radius = qRound(radius * factor);
+    }
+};
+
+struct CompositeShadowParams {
+    CompositeShadowParams() = default;
+
+    CompositeShadowParams(const QPoint &offset, const ShadowParams &shadow1, const ShadowParams &shadow2)
+        : offset(offset)
+        , shadow1(shadow1)
+        , shadow2(shadow2)
+    {
+    }
+
+    bool isNone() const
+    {
+        return qMax(shadow1.radius, shadow2.radius) == 0;
+    }
+
+    QPoint offset;
+    ShadowParams shadow1;
+    ShadowParams shadow2;
+
+    void operator*=(qreal factor)
+    {
+        offset *= factor;
+        shadow1 *= factor;
+        shadow2 *= factor;
+    }
+};
+
+} // namespace Breeze